@@ -0,0 +1,37 @@
+// Building a transient array per frame from the heap versus from a reset arena.
+// The steady-state allocation check lives in tests/AllocationTest.cpp, since the
+// operator new it installs would slow down every benchmark here.
+
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include <popBalloons/FrameArena.h>
+
+namespace {
+
+void BM_TransientVector_Heap(benchmark::State& state) {
+    const size_t count = static_cast<size_t>(state.range(0));
+    for (auto _ : state) {
+        std::vector<glm::vec4> vertices(count);
+        benchmark::DoNotOptimize(vertices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TransientVector_Heap)->RangeMultiplier(8)->Range(64, 1 << 15);
+
+void BM_TransientVector_Arena(benchmark::State& state) {
+    const size_t count = static_cast<size_t>(state.range(0));
+    FrameArena arena(count * sizeof(glm::vec4) + 64);
+    for (auto _ : state) {
+        {
+            ArenaVector<glm::vec4> vertices(count, glm::vec4(0.0f), ArenaAllocator<glm::vec4>(arena));
+            benchmark::DoNotOptimize(vertices.data());
+        }
+        arena.reset();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_TransientVector_Arena)->RangeMultiplier(8)->Range(64, 1 << 15);
+
+} // namespace
@@ -0,0 +1,174 @@
+// Mesh generation and loading: the balloon circle, indexVBO, tangent bases and loadOBJ over
+// synthetic meshes of increasing size.
+
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <glm/glm.hpp>
+
+#include <popBalloons/Renderer.h>
+#include <common/objloader.hpp>
+#include <common/vboindexer.hpp>
+#include <common/tangentspace.hpp>
+
+namespace {
+
+// An n x n grid of quads as unindexed triangles, the way loadOBJ hands meshes to indexVBO.
+// Interior vertices are shared by six triangles, so indexing has real work to do.
+void makeGridMesh(int n, std::vector<glm::vec3>& vertices, std::vector<glm::vec2>& uvs,
+                  std::vector<glm::vec3>& normals) {
+    vertices.clear();
+    uvs.clear();
+    normals.clear();
+
+    const int corners[6][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 0 }, { 1, 1 }, { 0, 1 } };
+    for (int row = 0; row < n; ++row) {
+        for (int column = 0; column < n; ++column) {
+            for (const auto& corner : corners) {
+                float u = static_cast<float>(column + corner[0]) / n;
+                float v = static_cast<float>(row + corner[1]) / n;
+                vertices.push_back(glm::vec3(u * 2.0f - 1.0f, v * 2.0f - 1.0f, 0.0f));
+                uvs.push_back(glm::vec2(u, v));
+                normals.push_back(glm::vec3(0.0f, 0.0f, 1.0f));
+            }
+        }
+    }
+}
+
+// The same grid written out as an OBJ file with shared v/vt/vn entries
+std::string writeGridObj(int n) {
+    std::string path = "popBalloons_bench_grid_" + std::to_string(n) + ".obj";
+    FILE* file = fopen(path.c_str(), "w");
+    if (!file) {
+        return std::string();
+    }
+
+    for (int row = 0; row <= n; ++row) {
+        for (int column = 0; column <= n; ++column) {
+            float u = static_cast<float>(column) / n;
+            float v = static_cast<float>(row) / n;
+            fprintf(file, "v %f %f %f\n", u * 2.0f - 1.0f, v * 2.0f - 1.0f, 0.0f);
+            fprintf(file, "vt %f %f\n", u, v);
+        }
+    }
+    fprintf(file, "vn 0.000000 0.000000 1.000000\n");
+
+    for (int row = 0; row < n; ++row) {
+        for (int column = 0; column < n; ++column) {
+            // OBJ indices are 1-based
+            int a = row * (n + 1) + column + 1;
+            int b = a + 1;
+            int c = a + n + 2;
+            int d = a + n + 1;
+            fprintf(file, "f %d/%d/1 %d/%d/1 %d/%d/1\n", a, a, b, b, c, c);
+            fprintf(file, "f %d/%d/1 %d/%d/1 %d/%d/1\n", a, a, c, c, d, d);
+        }
+    }
+
+    fclose(file);
+    return path;
+}
+
+void BM_CreateUnitCircleVertices(benchmark::State& state) {
+    const unsigned int segments = static_cast<unsigned int>(state.range(0));
+    for (auto _ : state) {
+        std::vector<glm::vec2> vertices = Renderer::createUnitCircleVertices(segments);
+        benchmark::DoNotOptimize(vertices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_CreateUnitCircleVertices)->RangeMultiplier(4)->Range(8, 1 << 12);
+
+// Grids stay under 65536 unique vertices so the unsigned short indices hold
+void BM_IndexVBO(benchmark::State& state) {
+    std::vector<glm::vec3> vertices, normals;
+    std::vector<glm::vec2> uvs;
+    makeGridMesh(static_cast<int>(state.range(0)), vertices, uvs, normals);
+
+    for (auto _ : state) {
+        std::vector<unsigned short> indices;
+        std::vector<glm::vec3> indexedVertices, indexedNormals;
+        std::vector<glm::vec2> indexedUvs;
+        indexVBO(vertices, uvs, normals, indices, indexedVertices, indexedUvs, indexedNormals);
+        benchmark::DoNotOptimize(indices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * vertices.size());
+}
+BENCHMARK(BM_IndexVBO)->RangeMultiplier(2)->Range(8, 128)->Unit(benchmark::kMicrosecond);
+
+// Past 65536 unique vertices, where the 16-bit path has to give up
+void BM_IndexVBO_Auto(benchmark::State& state) {
+    std::vector<glm::vec3> vertices, normals;
+    std::vector<glm::vec2> uvs;
+    makeGridMesh(static_cast<int>(state.range(0)), vertices, uvs, normals);
+
+    for (auto _ : state) {
+        IndexBuffer indices;
+        std::vector<glm::vec3> indexedVertices, indexedNormals;
+        std::vector<glm::vec2> indexedUvs;
+        indexVBO(vertices, uvs, normals, indices, indexedVertices, indexedUvs, indexedNormals);
+        benchmark::DoNotOptimize(indices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * vertices.size());
+}
+BENCHMARK(BM_IndexVBO_Auto)->RangeMultiplier(4)->Range(32, 512)->Unit(benchmark::kMillisecond);
+
+void BM_ComputeTangentBasis(benchmark::State& state) {
+    std::vector<glm::vec3> vertices, normals;
+    std::vector<glm::vec2> uvs;
+    makeGridMesh(static_cast<int>(state.range(0)), vertices, uvs, normals);
+
+    std::vector<glm::vec3> tangents, bitangents;
+    for (auto _ : state) {
+        computeTangentBasis(vertices, uvs, normals, tangents, bitangents);
+        benchmark::DoNotOptimize(tangents.data());
+    }
+    state.SetItemsProcessed(state.iterations() * vertices.size() / 3);
+}
+BENCHMARK(BM_ComputeTangentBasis)->RangeMultiplier(4)->Range(32, 512)->Unit(benchmark::kMillisecond);
+
+void BM_ComputeTangentBasisIndexed(benchmark::State& state) {
+    std::vector<glm::vec3> vertices, normals;
+    std::vector<glm::vec2> uvs;
+    makeGridMesh(static_cast<int>(state.range(0)), vertices, uvs, normals);
+
+    std::vector<unsigned int> indices;
+    std::vector<glm::vec3> indexedVertices, indexedNormals;
+    std::vector<glm::vec2> indexedUvs;
+    indexVBO(vertices, uvs, normals, indices, indexedVertices, indexedUvs, indexedNormals);
+
+    std::vector<glm::vec3> tangents, bitangents;
+    for (auto _ : state) {
+        computeTangentBasisIndexed(indices, indexedVertices, indexedUvs, indexedNormals, tangents, bitangents);
+        benchmark::DoNotOptimize(tangents.data());
+    }
+    state.SetItemsProcessed(state.iterations() * indices.size() / 3);
+}
+BENCHMARK(BM_ComputeTangentBasisIndexed)->RangeMultiplier(4)->Range(32, 512)->Unit(benchmark::kMillisecond);
+
+void BM_LoadOBJ(benchmark::State& state) {
+    std::string path = writeGridObj(static_cast<int>(state.range(0)));
+    if (path.empty()) {
+        state.SkipWithError("Could not write the synthetic OBJ file");
+        return;
+    }
+
+    size_t vertexCount = 0;
+    for (auto _ : state) {
+        std::vector<glm::vec3> vertices, normals;
+        std::vector<glm::vec2> uvs;
+        if (!loadOBJ(path.c_str(), vertices, uvs, normals)) {
+            state.SkipWithError("loadOBJ failed");
+            break;
+        }
+        vertexCount = vertices.size();
+        benchmark::DoNotOptimize(vertices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * vertexCount);
+
+    remove(path.c_str());
+}
+BENCHMARK(BM_LoadOBJ)->RangeMultiplier(4)->Range(8, 512)->Unit(benchmark::kMillisecond);
+
+} // namespace
@@ -0,0 +1,109 @@
+// Particle integration throughput: ParticleSystem (SoA + SIMD) against the
+// original std::vector<Fragment> loop that Game::update used to run.
+
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <random>
+#include <glm/glm.hpp>
+
+#include <popBalloons/Fragment.h>
+#include <popBalloons/ParticleSystem.h>
+
+namespace {
+
+const float kDeltaTime = 1.0f / 60.0f;
+
+// The fragment loop exactly as Game::update ran it before ParticleSystem
+void updateFragmentVector(std::vector<Fragment>& fragments, float deltaTime) {
+    for (auto it = fragments.begin(); it != fragments.end();) {
+        it->position += it->velocity * deltaTime;
+        it->velocity += glm::vec3(0.0f, -9.8f * deltaTime, 0.0f);
+        it->color.a = glm::max(it->color.a - (deltaTime / it->lifetime), 0.0f);
+        it->lifetime -= deltaTime;
+
+        if (it->lifetime <= 0.0f) {
+            it = fragments.erase(it);
+        } else {
+            ++it;
+        }
+    }
+}
+
+// Fragments that outlive the benchmark, so every iteration integrates the full set
+Fragment makeFragment(std::mt19937& gen, float lifetime) {
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    return Fragment(glm::vec3(dis(gen), dis(gen), 0.0f),
+                    glm::vec3(dis(gen), dis(gen), dis(gen)),
+                    glm::vec4(1.0f, 0.5f, 0.25f, 1.0f), 5.0f, lifetime);
+}
+
+void BM_FragmentVector_Update(benchmark::State& state) {
+    std::mt19937 gen(42);
+    std::vector<Fragment> fragments;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        fragments.push_back(makeFragment(gen, 1.0e9f));
+    }
+
+    for (auto _ : state) {
+        updateFragmentVector(fragments, kDeltaTime);
+        benchmark::DoNotOptimize(fragments.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FragmentVector_Update)->RangeMultiplier(8)->Range(1 << 10, 1 << 20);
+
+void BM_ParticleSystem_Update(benchmark::State& state) {
+    std::mt19937 gen(42);
+    ParticleSystem particles;
+    particles.reserve(state.range(0));
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        particles.emit(makeFragment(gen, 1.0e9f));
+    }
+
+    for (auto _ : state) {
+        particles.update(kDeltaTime);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetLabel(ParticleSystem::kernelName());
+}
+BENCHMARK(BM_ParticleSystem_Update)->RangeMultiplier(8)->Range(1 << 10, 1 << 20);
+
+// Half of the fragments expire in the measured step, which is where erase() goes quadratic
+void BM_FragmentVector_MassExpiry(benchmark::State& state) {
+    std::mt19937 gen(42);
+    for (auto _ : state) {
+        state.PauseTiming();
+        std::vector<Fragment> fragments;
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            fragments.push_back(makeFragment(gen, (i & 1) ? 1.0e9f : kDeltaTime * 0.5f));
+        }
+        state.ResumeTiming();
+
+        updateFragmentVector(fragments, kDeltaTime);
+        benchmark::DoNotOptimize(fragments.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_FragmentVector_MassExpiry)->RangeMultiplier(4)->Range(1 << 10, 1 << 14);
+
+void BM_ParticleSystem_MassExpiry(benchmark::State& state) {
+    std::mt19937 gen(42);
+    for (auto _ : state) {
+        state.PauseTiming();
+        ParticleSystem particles;
+        particles.reserve(state.range(0));
+        for (int64_t i = 0; i < state.range(0); ++i) {
+            particles.emit(makeFragment(gen, (i & 1) ? 1.0e9f : kDeltaTime * 0.5f));
+        }
+        state.ResumeTiming();
+
+        particles.update(kDeltaTime);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetLabel(ParticleSystem::kernelName());
+}
+BENCHMARK(BM_ParticleSystem_MassExpiry)->RangeMultiplier(4)->Range(1 << 10, 1 << 20);
+
+} // namespace
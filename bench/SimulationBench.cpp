@@ -0,0 +1,104 @@
+// Balloon simulation throughput: BalloonPool integration and grid hit testing
+// against the std::vector<Balloon> loops they replaced.
+
+#include <benchmark/benchmark.h>
+#include <vector>
+#include <random>
+#include <glm/glm.hpp>
+
+#include <popBalloons/Balloon.h>
+#include <popBalloons/BalloonPool.h>
+
+namespace {
+
+const float kDeltaTime = 1.0f / 60.0f;
+
+// Balloons spread over the play area; velocities point both ways so they stay
+// near it however many iterations the benchmark runs
+Balloon makeBalloon(std::mt19937& gen) {
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    std::uniform_real_distribution<float> disColor(0.0f, 1.0f);
+    Balloon balloon(glm::vec3(dis(gen), dis(gen), 0.0f), 0.2f,
+                    glm::vec3(disColor(gen), disColor(gen), disColor(gen)));
+    balloon.setVelocity(glm::vec3(0.0f, dis(gen), 0.0f));
+    return balloon;
+}
+
+void BM_BalloonVector_Update(benchmark::State& state) {
+    std::mt19937 gen(42);
+    std::vector<Balloon> balloons;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        balloons.push_back(makeBalloon(gen));
+    }
+
+    for (auto _ : state) {
+        for (Balloon& balloon : balloons) {
+            balloon.update(kDeltaTime);
+        }
+        benchmark::DoNotOptimize(balloons.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BalloonVector_Update)->RangeMultiplier(8)->Range(1 << 6, 1 << 18);
+
+void BM_BalloonPool_Update(benchmark::State& state) {
+    std::mt19937 gen(42);
+    BalloonPool balloons;
+    balloons.reserve(state.range(0));
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        balloons.add(makeBalloon(gen));
+    }
+
+    for (auto _ : state) {
+        balloons.update(kDeltaTime);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BalloonPool_Update)->RangeMultiplier(8)->Range(1 << 6, 1 << 18);
+
+// The linear scan Game::handleClick ran before the grid
+void BM_BalloonVector_HitTest(benchmark::State& state) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    std::vector<Balloon> balloons;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        balloons.push_back(makeBalloon(gen));
+    }
+
+    const float hitboxScale = 1.5f;
+    for (auto _ : state) {
+        glm::vec3 click(dis(gen), dis(gen), 0.0f);
+        int hit = -1;
+        for (size_t i = 0; i < balloons.size(); ++i) {
+            float hitboxRadius = balloons[i].getSize() * hitboxScale;
+            if (glm::distance(click, balloons[i].getPosition()) <= hitboxRadius) {
+                hit = static_cast<int>(i);
+                break;
+            }
+        }
+        benchmark::DoNotOptimize(hit);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BalloonVector_HitTest)->RangeMultiplier(8)->Range(1 << 6, 1 << 15);
+
+void BM_BalloonPool_HitTest(benchmark::State& state) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    BalloonPool balloons;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        balloons.add(makeBalloon(gen));
+    }
+
+    for (auto _ : state) {
+        size_t hit = 0;
+        bool found = balloons.findHit(dis(gen), dis(gen), 1.5f, HitPick::Topmost, hit);
+        benchmark::DoNotOptimize(found);
+        benchmark::DoNotOptimize(hit);
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_BalloonPool_HitTest)->RangeMultiplier(8)->Range(1 << 6, 1 << 15);
+
+} // namespace
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Compare a popBalloons_bench JSON run against a stored baseline.
+
+    popBalloons_bench --benchmark_out=results.json --benchmark_out_format=json
+    bench/compare_baseline.py results.json                 # check, exit 1 on regressions
+    bench/compare_baseline.py results.json --update        # store results as the baseline
+
+Timings only compare on the machine that recorded them, so no baseline is
+committed: record one with --update before the first check. The bench_check
+target passes --skip-missing, which reports a missing baseline and succeeds.
+
+Benchmarks are matched by name and compared on CPU time per iteration. When a
+run used --benchmark_repetitions, the median aggregate is used instead of the
+individual repetitions. A benchmark that reported an error, or that is in the
+baseline but missing from the results, fails the check; one that is new in the
+results is only reported, so adding a benchmark does not need a new baseline.
+"""
+
+import argparse
+import json
+import os
+import sys
+
+DEFAULT_BASELINE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "baseline.json")
+
+# Google Benchmark reports times in the benchmark's own unit
+UNIT_TO_NS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load_times(path, errors=None):
+    """Returns {benchmark name: CPU ns per iteration} for one JSON output file.
+
+    Benchmarks that reported an error are left out, and added to errors as
+    {name: message} when it is given.
+    """
+    with open(path) as f:
+        data = json.load(f)
+
+    times = {}
+    medians = {}
+    for entry in data.get("benchmarks", []):
+        if entry.get("error_occurred"):
+            if errors is not None:
+                errors[entry.get("run_name", entry["name"])] = entry.get("error_message", "")
+            continue
+        ns = entry["cpu_time"] * UNIT_TO_NS[entry.get("time_unit", "ns")]
+        if entry.get("run_type") == "aggregate":
+            if entry.get("aggregate_name") == "median":
+                medians[entry["run_name"]] = ns
+        else:
+            name = entry.get("run_name", entry["name"])
+            # Without a median, keep the fastest repetition as the least noisy
+            times[name] = min(ns, times.get(name, ns))
+
+    times.update(medians)
+    return times
+
+
+def format_ns(ns):
+    for unit, scale in (("s", 1e9), ("ms", 1e6), ("us", 1e3)):
+        if ns >= scale:
+            return "%.3f %s" % (ns / scale, unit)
+    return "%.1f ns" % ns
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("results", help="JSON written by popBalloons_bench --benchmark_out")
+    parser.add_argument("--baseline", default=DEFAULT_BASELINE, help="baseline JSON (default: %(default)s)")
+    parser.add_argument("--threshold", type=float, default=0.10,
+                        help="allowed slowdown as a fraction of the baseline (default: %(default)s)")
+    parser.add_argument("--update", action="store_true", help="copy the results over the baseline and exit")
+    parser.add_argument("--skip-missing", action="store_true",
+                        help="succeed without checking when there is no baseline yet")
+    args = parser.parse_args()
+
+    if args.update:
+        with open(args.results) as f:
+            data = json.load(f)
+        with open(args.baseline, "w") as f:
+            json.dump(data, f, indent=2)
+            f.write("\n")
+        print("Stored %d benchmarks as the baseline in %s" % (len(load_times(args.baseline)), args.baseline))
+        return 0
+
+    if not os.path.exists(args.baseline):
+        print("No baseline at %s; record one on this machine with --update" % args.baseline, file=sys.stderr)
+        if args.skip_missing:
+            errors = {}
+            load_times(args.results, errors)
+            for name in sorted(errors):
+                print("  ERROR %-60s %s" % (name, errors[name]))
+            if errors:
+                print("%d benchmark(s) errored" % len(errors))
+                return 1
+            print("Skipping the regression check")
+            return 0
+        return 2
+
+    baseline = load_times(args.baseline)
+    errors = {}
+    results = load_times(args.results, errors)
+
+    failures = 0
+    for name in sorted(errors):
+        print("  ERROR %-60s %s" % (name, errors[name]))
+        failures += 1
+
+    regressions = 0
+    for name in sorted(results):
+        if name not in baseline:
+            print("  new   %-60s %12s" % (name, format_ns(results[name])))
+            continue
+
+        change = results[name] / baseline[name] - 1.0
+        if change > args.threshold:
+            status = "SLOW"
+            regressions += 1
+        elif change < -args.threshold:
+            status = "fast"
+        else:
+            status = "ok"
+        print("  %-5s %-60s %12s -> %12s  %+6.1f%%" % (
+            status, name, format_ns(baseline[name]), format_ns(results[name]), change * 100.0))
+
+    for name in sorted(set(baseline) - set(results) - set(errors)):
+        print("  GONE  %s" % name)
+        failures += 1
+
+    if failures:
+        print("%d benchmark(s) errored or missing from the results" % failures)
+    if regressions:
+        print("%d benchmark(s) slower than the baseline by more than %.0f%%" % (regressions, args.threshold * 100.0))
+    if failures or regressions:
+        return 1
+    print("No regressions beyond %.0f%%" % (args.threshold * 100.0))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
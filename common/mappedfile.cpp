@@ -0,0 +1,122 @@
+#include "mappedfile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+	: view(nullptr), length(0), opened(false)
+#ifdef _WIN32
+	, fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr)
+#else
+	, fd(-1)
+#endif
+{
+}
+
+MappedFile::~MappedFile(){
+	close();
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const char * path){
+	close();
+
+	fileHandle = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if ( fileHandle == INVALID_HANDLE_VALUE ){
+		return false;
+	}
+
+	LARGE_INTEGER fileSize;
+	if ( !GetFileSizeEx(fileHandle, &fileSize) ){
+		close();
+		return false;
+	}
+	length = (size_t)fileSize.QuadPart;
+	opened = true;
+	if ( length == 0 ){
+		return true; // Nothing to map
+	}
+
+	mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if ( mappingHandle ){
+		view = (const char*)MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0);
+	}
+	if ( !view ){
+		close();
+		return false;
+	}
+	return true;
+}
+
+void MappedFile::close(){
+	if ( view ){
+		UnmapViewOfFile(view);
+	}
+	if ( mappingHandle ){
+		CloseHandle(mappingHandle);
+	}
+	if ( fileHandle != INVALID_HANDLE_VALUE ){
+		CloseHandle(fileHandle);
+	}
+	view = nullptr;
+	length = 0;
+	opened = false;
+	mappingHandle = nullptr;
+	fileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool MappedFile::open(const char * path){
+	close();
+
+	fd = ::open(path, O_RDONLY);
+	if ( fd < 0 ){
+		return false;
+	}
+
+	struct stat info;
+	if ( fstat(fd, &info) != 0 ){
+		close();
+		return false;
+	}
+	length = (size_t)info.st_size;
+	opened = true;
+	if ( length == 0 ){
+		return true; // mmap rejects zero-length mappings
+	}
+
+	void * mapped = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+	if ( mapped == MAP_FAILED ){
+		close();
+		return false;
+	}
+	view = (const char*)mapped;
+
+	// Files are parsed front to back, so let the kernel read ahead aggressively
+	madvise(mapped, length, MADV_SEQUENTIAL);
+	return true;
+}
+
+void MappedFile::close(){
+	if ( view ){
+		munmap((void*)view, length);
+	}
+	if ( fd >= 0 ){
+		::close(fd);
+	}
+	view = nullptr;
+	length = 0;
+	opened = false;
+	fd = -1;
+}
+
+#endif
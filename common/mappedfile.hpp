@@ -0,0 +1,35 @@
+#ifndef MAPPEDFILE_HPP
+#define MAPPEDFILE_HPP
+
+#include <cstddef>
+
+// Read-only view of a whole file mapped into memory. The view stays valid
+// until close() or destruction; empty files map to a null, zero-length view.
+class MappedFile {
+public:
+	MappedFile();
+	~MappedFile();
+
+	MappedFile(const MappedFile &) = delete;
+	MappedFile & operator=(const MappedFile &) = delete;
+
+	bool open(const char * path);
+	void close();
+
+	bool        isOpen() const { return opened; }
+	const char* data() const   { return view; }
+	size_t      size() const   { return length; }
+
+private:
+	const char* view;
+	size_t      length;
+	bool        opened;
+#ifdef _WIN32
+	void*       fileHandle;
+	void*       mappingHandle;
+#else
+	int         fd;
+#endif
+};
+
+#endif
@@ -0,0 +1,240 @@
+#include <vector>
+#include <stdio.h>
+#include <string.h>
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include "meshcache.hpp"
+#include "objloader.hpp"
+#include "tangentspace.hpp"
+#include "vboindexer.hpp"
+
+namespace {
+
+const char kMagic[4] = {'P', 'B', 'M', 'C'};
+
+inline uint64_t rotl(uint64_t x, int r){
+	return (x << r) | (x >> (64 - r));
+}
+
+// Eight bytes per step with a multiply-rotate mix: fast enough to hash a source
+// file on every start, and only used to notice that the file changed
+uint64_t hashBytes(const unsigned char * data, size_t size){
+	const uint64_t prime1 = 0x9E3779B185EBCA87ull;
+	const uint64_t prime2 = 0xC2B2AE3D27D4EB4Full;
+	uint64_t h = prime2 ^ (uint64_t)size;
+
+	size_t i = 0;
+	for ( ; i + 8 <= size; i += 8 ){
+		uint64_t word;
+		memcpy(&word, data + i, 8);
+		h = rotl(h ^ (word * prime2), 31) * prime1;
+	}
+	for ( ; i < size; i++ ){
+		h = rotl(h ^ (data[i] * prime1), 11) * prime2;
+	}
+
+	h ^= h >> 33; h *= prime2;
+	h ^= h >> 29; h *= prime1;
+	h ^= h >> 32;
+	return h;
+}
+
+// Interleaves the indexed attribute arrays in semantic order
+void interleave(
+	const std::vector<const float*> & streams,
+	const std::vector<uint32_t> & components,
+	size_t vertexCount,
+	std::vector<float> & out
+){
+	uint32_t floatsPerVertex = 0;
+	for ( uint32_t c : components ){
+		floatsPerVertex += c;
+	}
+
+	out.resize(vertexCount * floatsPerVertex);
+	float * dst = out.data();
+	for ( size_t v=0; v<vertexCount; v++ ){
+		for ( size_t s=0; s<streams.size(); s++ ){
+			memcpy(dst, streams[s] + v * components[s], components[s] * sizeof(float));
+			dst += components[s];
+		}
+	}
+}
+
+} // namespace
+
+bool hashFileContents(const char * path, uint64_t & hash){
+	MappedFile file;
+	if ( !file.open(path) ){
+		return false;
+	}
+	hash = hashBytes((const unsigned char*)file.data(), file.size());
+	return true;
+}
+
+bool bakeMesh(const char * objPath, const char * cachePath, bool withTangents){
+	uint64_t sourceHash;
+	if ( !hashFileContents(objPath, sourceHash) ){
+		printf("%s could not be opened for baking\n", objPath);
+		return false;
+	}
+
+	std::vector<glm::vec3> vertices, normals;
+	std::vector<glm::vec2> uvs;
+	if ( !loadOBJ(objPath, vertices, uvs, normals) ){
+		return false;
+	}
+
+	std::vector<unsigned int> indices;
+	std::vector<glm::vec3> indexed_vertices, indexed_normals, indexed_tangents, indexed_bitangents;
+	std::vector<glm::vec2> indexed_uvs;
+	if ( withTangents ){
+		std::vector<glm::vec3> tangents, bitangents;
+		computeTangentBasis(vertices, uvs, normals, tangents, bitangents);
+		indexVBO_TBN(vertices, uvs, normals, tangents, bitangents,
+		             indices, indexed_vertices, indexed_uvs, indexed_normals, indexed_tangents, indexed_bitangents);
+	}else{
+		indexVBO(vertices, uvs, normals, indices, indexed_vertices, indexed_uvs, indexed_normals);
+	}
+
+	if ( indexed_vertices.empty() ){
+		printf("%s has no triangles to bake\n", objPath);
+		return false;
+	}
+
+	MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, kMagic, sizeof(kMagic));
+	header.version = kMeshCacheVersion;
+	header.sourceHash = sourceHash;
+	header.vertexCount = (uint32_t)indexed_vertices.size();
+	header.indexCount = (uint32_t)indices.size();
+	header.indexSize = indexed_vertices.size() > 65536 ? 4 : 2;
+
+	std::vector<const float*> streams;
+	std::vector<uint32_t> components;
+	auto addAttribute = [&](MeshAttributeSemantic semantic, uint32_t count, const float * data){
+		MeshAttribute & attribute = header.attributes[header.attributeCount++];
+		attribute.semantic = semantic;
+		attribute.components = count;
+		attribute.offset = header.vertexStride;
+		header.vertexStride += count * sizeof(float);
+		streams.push_back(data);
+		components.push_back(count);
+	};
+	addAttribute(MESH_ATTRIBUTE_POSITION, 3, &indexed_vertices[0].x);
+	addAttribute(MESH_ATTRIBUTE_UV,       2, &indexed_uvs[0].x);
+	addAttribute(MESH_ATTRIBUTE_NORMAL,   3, &indexed_normals[0].x);
+	if ( withTangents ){
+		addAttribute(MESH_ATTRIBUTE_TANGENT,   3, &indexed_tangents[0].x);
+		addAttribute(MESH_ATTRIBUTE_BITANGENT, 3, &indexed_bitangents[0].x);
+	}
+
+	std::vector<float> interleaved;
+	interleave(streams, components, indexed_vertices.size(), interleaved);
+
+	// Vertex data starts on a 16-byte boundary so it can be read in place
+	header.vertexOffset = (sizeof(MeshCacheHeader) + 15) & ~(uint64_t)15;
+	header.indexOffset = header.vertexOffset + interleaved.size() * sizeof(float);
+
+	FILE * file = fopen(cachePath, "wb");
+	if ( !file ){
+		printf("%s could not be opened for writing\n", cachePath);
+		return false;
+	}
+
+	static const unsigned char padding[16] = {0};
+	bool ok = fwrite(&header, sizeof(header), 1, file) == 1;
+	ok = ok && fwrite(padding, 1, header.vertexOffset - sizeof(header), file) == header.vertexOffset - sizeof(header);
+	ok = ok && fwrite(interleaved.data(), sizeof(float), interleaved.size(), file) == interleaved.size();
+	if ( header.indexSize == 2 ){
+		std::vector<unsigned short> narrow(indices.begin(), indices.end());
+		ok = ok && fwrite(narrow.data(), sizeof(unsigned short), narrow.size(), file) == narrow.size();
+	}else{
+		ok = ok && fwrite(indices.data(), sizeof(unsigned int), indices.size(), file) == indices.size();
+	}
+	ok = fclose(file) == 0 && ok;
+
+	if ( !ok ){
+		printf("Writing %s failed\n", cachePath);
+		remove(cachePath);
+		return false;
+	}
+	printf("Baked %s: %u vertices, %u indices\n", cachePath, header.vertexCount, header.indexCount);
+	return true;
+}
+
+bool MeshCache::open(const char * cachePath, uint64_t expectedSourceHash){
+	close();
+	if ( !file.open(cachePath) ){
+		return false;
+	}
+
+	const MeshCacheHeader * candidate = (const MeshCacheHeader*)file.data();
+	bool valid = file.size() >= sizeof(MeshCacheHeader) &&
+	             memcmp(candidate->magic, kMagic, sizeof(kMagic)) == 0 &&
+	             candidate->version == kMeshCacheVersion &&
+	             candidate->attributeCount <= MESH_ATTRIBUTE_COUNT &&
+	             (candidate->indexSize == 2 || candidate->indexSize == 4) &&
+	             candidate->vertexOffset + (uint64_t)candidate->vertexCount * candidate->vertexStride <= file.size() &&
+	             candidate->indexOffset + (uint64_t)candidate->indexCount * candidate->indexSize <= file.size();
+	if ( !valid || (expectedSourceHash != 0 && candidate->sourceHash != expectedSourceHash) ){
+		file.close();
+		return false;
+	}
+
+	header = candidate;
+	return true;
+}
+
+bool loadMeshCached(const char * objPath, const char * cachePath, bool withTangents, MeshBuffers & out){
+	memset(&out, 0, sizeof(out));
+
+	uint64_t sourceHash = 0;
+	if ( !hashFileContents(objPath, sourceHash) ){
+		// Shipping builds may carry only the baked file
+		printf("%s is missing, using %s as is\n", objPath, cachePath);
+	}
+
+	MeshCache cache;
+	if ( !cache.open(cachePath, sourceHash) ){
+		if ( sourceHash == 0 || !bakeMesh(objPath, cachePath, withTangents) || !cache.open(cachePath, sourceHash) ){
+			return false;
+		}
+	}
+	const MeshCacheHeader & header = cache.getHeader();
+
+	glGenVertexArrays(1, &out.vertexArray);
+	glBindVertexArray(out.vertexArray);
+
+	// Straight from the mapping to the driver, with no intermediate copy
+	glGenBuffers(1, &out.vertexBuffer);
+	glBindBuffer(GL_ARRAY_BUFFER, out.vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, cache.vertexBytes(), cache.vertexData(), GL_STATIC_DRAW);
+
+	glGenBuffers(1, &out.indexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, out.indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, cache.indexBytes(), cache.indexData(), GL_STATIC_DRAW);
+
+	for ( uint32_t i=0; i<header.attributeCount; i++ ){
+		const MeshAttribute & attribute = header.attributes[i];
+		glEnableVertexAttribArray(attribute.semantic);
+		glVertexAttribPointer(attribute.semantic, attribute.components, GL_FLOAT, GL_FALSE,
+		                      header.vertexStride, (void*)(uintptr_t)attribute.offset);
+	}
+
+	glBindVertexArray(0);
+
+	out.indexCount = (GLsizei)header.indexCount;
+	out.indexType = header.indexSize == 4 ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+	return true;
+}
+
+void deleteMeshBuffers(MeshBuffers & buffers){
+	glDeleteBuffers(1, &buffers.indexBuffer);
+	glDeleteBuffers(1, &buffers.vertexBuffer);
+	glDeleteVertexArrays(1, &buffers.vertexArray);
+	memset(&buffers, 0, sizeof(buffers));
+}
@@ -0,0 +1,89 @@
+#ifndef MESHCACHE_HPP
+#define MESHCACHE_HPP
+
+#include <cstdint>
+#include <cstddef>
+
+#include "mappedfile.hpp"
+
+// Baked mesh file (.pbmesh): everything loadOBJ + computeTangentBasis + indexVBO
+// would produce, laid out so loading is a map and two buffer uploads.
+//
+//   MeshCacheHeader
+//   interleaved vertices  (vertexCount * vertexStride bytes, at vertexOffset)
+//   indices               (indexCount * indexSize bytes, at indexOffset)
+//
+// All fields are little-endian. sourceHash is hashFileContents() of the OBJ the
+// mesh was baked from; a cache whose hash no longer matches its source is stale.
+
+enum MeshAttributeSemantic {
+	MESH_ATTRIBUTE_POSITION  = 0, // vec3
+	MESH_ATTRIBUTE_UV        = 1, // vec2
+	MESH_ATTRIBUTE_NORMAL    = 2, // vec3
+	MESH_ATTRIBUTE_TANGENT   = 3, // vec3
+	MESH_ATTRIBUTE_BITANGENT = 4, // vec3
+	MESH_ATTRIBUTE_COUNT
+};
+
+struct MeshAttribute {
+	uint32_t semantic;   // MeshAttributeSemantic, also the attribute location it binds to
+	uint32_t components; // Floats per vertex
+	uint32_t offset;     // Byte offset inside one interleaved vertex
+};
+
+struct MeshCacheHeader {
+	char          magic[4];      // "PBMC"
+	uint32_t      version;
+	uint64_t      sourceHash;
+	uint32_t      vertexCount;
+	uint32_t      vertexStride;
+	uint32_t      indexCount;
+	uint32_t      indexSize;     // 2 or 4 bytes
+	uint64_t      vertexOffset;
+	uint64_t      indexOffset;
+	uint32_t      attributeCount;
+	uint32_t      reserved;
+	MeshAttribute attributes[MESH_ATTRIBUTE_COUNT];
+};
+
+const uint32_t kMeshCacheVersion = 1;
+
+// 64-bit hash of a file's bytes; false if it cannot be read
+bool hashFileContents(const char * path, uint64_t & hash);
+
+// Parses, tangent-spaces (optionally) and indexes an OBJ, then writes the baked file
+bool bakeMesh(const char * objPath, const char * cachePath, bool withTangents);
+
+// Read-only view of a baked mesh straight out of the page cache
+class MeshCache {
+public:
+	// expectedSourceHash of 0 skips the staleness check
+	bool open(const char * cachePath, uint64_t expectedSourceHash = 0);
+	void close() { file.close(); header = nullptr; }
+
+	const MeshCacheHeader & getHeader() const { return *header; }
+	const void* vertexData() const { return file.data() + header->vertexOffset; }
+	const void* indexData() const  { return file.data() + header->indexOffset; }
+	size_t vertexBytes() const { return (size_t)header->vertexCount * header->vertexStride; }
+	size_t indexBytes() const  { return (size_t)header->indexCount * header->indexSize; }
+
+private:
+	MappedFile file;
+	const MeshCacheHeader * header = nullptr;
+};
+
+// GPU copy of a baked mesh. Attributes are bound to location = semantic.
+struct MeshBuffers {
+	GLuint  vertexArray;
+	GLuint  vertexBuffer;
+	GLuint  indexBuffer;
+	GLsizei indexCount;
+	GLenum  indexType;
+};
+
+// Loads objPath through its cache at cachePath, re-baking first when the cache is
+// missing or was baked from different contents. Needs a current GL context.
+bool loadMeshCached(const char * objPath, const char * cachePath, bool withTangents, MeshBuffers & out);
+void deleteMeshBuffers(MeshBuffers & buffers);
+
+#endif
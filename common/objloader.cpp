@@ -2,20 +2,254 @@
 #include <stdio.h>
 #include <string>
 #include <cstring>
+#include <cstdint>
+#include <charconv>
+#include <future>
+#include <array>
+#include <algorithm>
 
 #include <glm/glm.hpp>
 
 #include "objloader.hpp"
+#include "mappedfile.hpp"
+#include "threadpool.hpp"
 
-// Very, VERY simple OBJ loader.
-// Here is a short list of features a real function would provide : 
-// - Binary files. Reading a model should be just a few memcpy's away, not parsing a file at runtime. In short : OBJ is not very great.
-// - Animations & bones (includes bones weights)
-// - Multiple UVs
-// - All attributes should be optional, not "forced"
-// - More stable. Change a line in the OBJ file and it crashes.
-// - More secure. Change another line and you can inject code.
-// - Loading from memory, stream, etc
+// Memory-mapped OBJ loader.
+// The file is split into line-aligned chunks that are parsed in parallel, then
+// the chunks are stitched back together in file order. Supported:
+// - v, vt and vn (extra components such as w are ignored)
+// - f with any number of corners (fan-triangulated), as v, v/vt, v//vn or v/vt/vn
+// - negative (relative) indices
+// Everything else (o, g, s, usemtl, mtllib, l, p, comments) is skipped.
+// Faces without UVs get (0,0); faces without normals get their flat face normal.
+
+namespace {
+
+const size_t kMinChunkBytes = 256 * 1024; // Below this, a thread costs more than it saves
+
+// A face corner as written in the file: 1-based absolute indices, or chunk-local
+// 0-based ones when the file used a negative index (resolved at merge time)
+struct Corner{
+	int32_t index[3];  // position, uv, normal
+	uint8_t relative;  // Bit k set: index[k] is chunk-local
+	uint8_t present;   // Bit k set: attribute k was given
+};
+
+struct Chunk{
+	std::vector<glm::vec3> positions;
+	std::vector<glm::vec2> uvs;
+	std::vector<glm::vec3> normals;
+	std::vector<Corner>    corners; // Three per triangle
+	bool        failed;
+	const char* errorAt;
+	Chunk() : failed(false), errorAt(nullptr) {}
+};
+
+inline bool isBlank(char c){
+	return c == ' ' || c == '\t' || c == '\r';
+}
+
+inline const char* skipBlanks(const char* p, const char* end){
+	while ( p < end && isBlank(*p) ){
+		p++;
+	}
+	return p;
+}
+
+inline const char* skipLine(const char* p, const char* end){
+	const char* newline = (const char*)memchr(p, '\n', end - p);
+	return newline ? newline + 1 : end;
+}
+
+// Reads up to count floats; missing trailing components stay at their default
+const char* parseFloats(const char* p, const char* end, float* values, int count, bool& ok){
+	for ( int i=0; i<count; i++ ){
+		p = skipBlanks(p, end);
+		if ( p == end || *p == '\n' ){
+			ok = i > 0;
+			return p;
+		}
+		if ( *p == '+' ){
+			p++; // from_chars does not take an explicit plus sign
+		}
+		std::from_chars_result result = std::from_chars(p, end, values[i]);
+		if ( result.ec != std::errc() ){
+			ok = false;
+			return p;
+		}
+		p = result.ptr;
+	}
+	ok = true;
+	return p;
+}
+
+// One v, v/vt, v//vn or v/vt/vn group
+const char* parseCorner(const char* p, const char* end, const size_t counts[3], Corner& corner, bool& ok){
+	corner.relative = 0;
+	corner.present = 0;
+	for ( int k=0; k<3; k++ ){
+		corner.index[k] = 0;
+		if ( k > 0 ){
+			if ( p == end || *p != '/' ){
+				break;
+			}
+			p++;
+		}
+
+		if ( p < end && (*p == '-' || (*p >= '0' && *p <= '9')) ){
+			int value = 0;
+			std::from_chars_result result = std::from_chars(p, end, value);
+			if ( result.ec != std::errc() || value == 0 ){
+				ok = false;
+				return p;
+			}
+			p = result.ptr;
+			corner.present |= (uint8_t)(1 << k);
+			if ( value < 0 ){
+				corner.index[k] = (int32_t)counts[k] + value;
+				corner.relative |= (uint8_t)(1 << k);
+			}else{
+				corner.index[k] = value;
+			}
+		}else if ( k == 0 ){
+			ok = false; // The position is mandatory
+			return p;
+		}
+	}
+	ok = true;
+	return p;
+}
+
+void parseChunk(const char* p, const char* end, Chunk& chunk){
+	std::vector<Corner> face;
+
+	while ( p < end ){
+		const char* line = skipBlanks(p, end);
+		if ( line == end ){
+			break;
+		}
+
+		bool ok = true;
+		const char* q = line;
+		if ( q[0] == 'v' && q + 1 < end && isBlank(q[1]) ){
+			float v[3] = {0.0f, 0.0f, 0.0f};
+			q = parseFloats(q + 1, end, v, 3, ok);
+			chunk.positions.push_back(glm::vec3(v[0], v[1], v[2]));
+		}else if ( q[0] == 'v' && q + 2 < end && q[1] == 't' && isBlank(q[2]) ){
+			float v[2] = {0.0f, 0.0f};
+			q = parseFloats(q + 2, end, v, 2, ok);
+			chunk.uvs.push_back(glm::vec2(v[0], -v[1])); // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
+		}else if ( q[0] == 'v' && q + 2 < end && q[1] == 'n' && isBlank(q[2]) ){
+			float v[3] = {0.0f, 0.0f, 0.0f};
+			q = parseFloats(q + 2, end, v, 3, ok);
+			chunk.normals.push_back(glm::vec3(v[0], v[1], v[2]));
+		}else if ( q[0] == 'f' && q + 1 < end && isBlank(q[1]) ){
+			const size_t counts[3] = {chunk.positions.size(), chunk.uvs.size(), chunk.normals.size()};
+			face.clear();
+			q = skipBlanks(q + 1, end);
+			while ( ok && q < end && *q != '\n' && *q != '#' ){
+				Corner corner;
+				q = parseCorner(q, end, counts, corner, ok);
+				face.push_back(corner);
+				q = skipBlanks(q, end);
+			}
+			ok = ok && face.size() >= 3;
+
+			// Triangulate as a fan around the first corner
+			for ( size_t i=2; ok && i<face.size(); i++ ){
+				chunk.corners.push_back(face[0]);
+				chunk.corners.push_back(face[i-1]);
+				chunk.corners.push_back(face[i]);
+			}
+		}
+
+		if ( !ok ){
+			chunk.failed = true;
+			chunk.errorAt = line;
+			return;
+		}
+		p = skipLine(q, end);
+	}
+}
+
+// Cuts [begin, end) into roughly equal pieces that each end just after a newline
+std::vector<const char*> splitLines(const char* begin, const char* end, size_t pieces){
+	std::vector<const char*> bounds(1, begin);
+	size_t step = (end - begin) / pieces;
+	for ( size_t i=1; i<pieces; i++ ){
+		const char* cut = begin + i * step;
+		if ( cut <= bounds.back() ){
+			continue;
+		}
+		cut = skipLine(cut, end);
+		if ( cut < end ){
+			bounds.push_back(cut);
+		}
+	}
+	bounds.push_back(end);
+	return bounds;
+}
+
+// Converts a corner index to a 0-based index into the merged attribute array
+inline bool resolve(const Corner& corner, int k, size_t chunkBase, size_t total, size_t& out){
+	int64_t index = (corner.relative & (1 << k)) ? (int64_t)chunkBase + corner.index[k]
+	                                             : (int64_t)corner.index[k] - 1;
+	if ( index < 0 || index >= (int64_t)total ){
+		return false;
+	}
+	out = (size_t)index;
+	return true;
+}
+
+// Writes one chunk's triangles into its slice of the output arrays
+bool emitTriangles(
+	const Chunk& chunk, const size_t base[3],
+	const std::vector<glm::vec3>& positions, const std::vector<glm::vec2>& uvs, const std::vector<glm::vec3>& normals,
+	glm::vec3* outVertices, glm::vec2* outUvs, glm::vec3* outNormals
+){
+	for ( size_t i=0; i<chunk.corners.size(); i+=3 ){
+		bool hasNormals = true;
+		for ( size_t c=0; c<3; c++ ){
+			const Corner& corner = chunk.corners[i+c];
+			size_t index;
+			if ( !resolve(corner, 0, base[0], positions.size(), index) ){
+				return false;
+			}
+			outVertices[i+c] = positions[index];
+
+			outUvs[i+c] = glm::vec2(0.0f);
+			if ( corner.present & 2 ){
+				if ( !resolve(corner, 1, base[1], uvs.size(), index) ){
+					return false;
+				}
+				outUvs[i+c] = uvs[index];
+			}
+
+			if ( corner.present & 4 ){
+				if ( !resolve(corner, 2, base[2], normals.size(), index) ){
+					return false;
+				}
+				outNormals[i+c] = normals[index];
+			}else{
+				hasNormals = false;
+			}
+		}
+
+		if ( !hasNormals ){
+			glm::vec3 faceNormal = glm::cross(outVertices[i+1] - outVertices[i], outVertices[i+2] - outVertices[i]);
+			float length = glm::length(faceNormal);
+			faceNormal = length > 0.0f ? faceNormal / length : glm::vec3(0.0f);
+			for ( size_t c=0; c<3; c++ ){
+				if ( !(chunk.corners[i+c].present & 4) ){
+					outNormals[i+c] = faceNormal;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+} // namespace
 
 bool loadOBJ(
 	const char * path, 
@@ -25,88 +259,93 @@ bool loadOBJ(
 ){
 	printf("Loading OBJ file %s...\n", path);
 
-	std::vector<unsigned int> vertexIndices, uvIndices, normalIndices;
-	std::vector<glm::vec3> temp_vertices; 
-	std::vector<glm::vec2> temp_uvs;
-	std::vector<glm::vec3> temp_normals;
-
-
-	FILE * file = fopen(path, "r");
-	if( file == NULL ){
+	MappedFile file;
+	if( !file.open(path) ){
 		printf("Impossible to open the file ! Are you in the right path ? See Tutorial 1 for details\n");
-		getchar();
 		return false;
 	}
 
-	while( 1 ){
-
-		char lineHeader[128];
-		// read the first word of the line
-		int res = fscanf(file, "%s", lineHeader);
-		if (res == EOF)
-			break; // EOF = End Of File. Quit the loop.
-
-		// else : parse lineHeader
-		
-		if ( strcmp( lineHeader, "v" ) == 0 ){
-			glm::vec3 vertex;
-			fscanf(file, "%f %f %f\n", &vertex.x, &vertex.y, &vertex.z );
-			temp_vertices.push_back(vertex);
-		}else if ( strcmp( lineHeader, "vt" ) == 0 ){
-			glm::vec2 uv;
-			fscanf(file, "%f %f\n", &uv.x, &uv.y );
-			uv.y = -uv.y; // Invert V coordinate since we will only use DDS texture, which are inverted. Remove if you want to use TGA or BMP loaders.
-			temp_uvs.push_back(uv);
-		}else if ( strcmp( lineHeader, "vn" ) == 0 ){
-			glm::vec3 normal;
-			fscanf(file, "%f %f %f\n", &normal.x, &normal.y, &normal.z );
-			temp_normals.push_back(normal);
-		}else if ( strcmp( lineHeader, "f" ) == 0 ){
-			std::string vertex1, vertex2, vertex3;
-			unsigned int vertexIndex[3], uvIndex[3], normalIndex[3];
-			int matches = fscanf(file, "%d/%d/%d %d/%d/%d %d/%d/%d\n", &vertexIndex[0], &uvIndex[0], &normalIndex[0], &vertexIndex[1], &uvIndex[1], &normalIndex[1], &vertexIndex[2], &uvIndex[2], &normalIndex[2] );
-			if (matches != 9){
-				printf("File can't be read by our simple parser :-( Try exporting with other options\n");
-				fclose(file);
-				return false;
-			}
-			vertexIndices.push_back(vertexIndex[0]);
-			vertexIndices.push_back(vertexIndex[1]);
-			vertexIndices.push_back(vertexIndex[2]);
-			uvIndices    .push_back(uvIndex[0]);
-			uvIndices    .push_back(uvIndex[1]);
-			uvIndices    .push_back(uvIndex[2]);
-			normalIndices.push_back(normalIndex[0]);
-			normalIndices.push_back(normalIndex[1]);
-			normalIndices.push_back(normalIndex[2]);
-		}else{
-			// Probably a comment, eat up the rest of the line
-			char stupidBuffer[1000];
-			fgets(stupidBuffer, 1000, file);
+	const char* begin = file.data();
+	const char* end = begin + file.size();
+
+	ThreadPool & pool = ThreadPool::shared();
+	size_t pieces = std::max<size_t>(1, std::min<size_t>(pool.size(), file.size() / kMinChunkBytes));
+	std::vector<const char*> bounds = splitLines(begin, end, pieces);
+	std::vector<Chunk> chunks(bounds.size() - 1);
+
+	// Parse: every chunk is independent
+	std::vector< std::future<void> > pending;
+	for ( size_t i=1; i<chunks.size(); i++ ){
+		pending.push_back(pool.submit([&, i](){ parseChunk(bounds[i], bounds[i+1], chunks[i]); }));
+	}
+	parseChunk(bounds[0], bounds[1], chunks[0]);
+	for ( std::future<void> & job : pending ){
+		job.get();
+	}
+
+	for ( const Chunk & chunk : chunks ){
+		if ( chunk.failed ){
+			size_t line = 1 + std::count(begin, chunk.errorAt, '\n');
+			printf("File can't be read by our simple parser :-( Line %u is malformed\n", (unsigned int)line);
+			return false;
 		}
+	}
 
+	// Merge: attributes are concatenated in file order, and each chunk learns
+	// where its attributes and its triangles start in the combined arrays
+	std::vector<glm::vec3> positions, normals;
+	std::vector<glm::vec2> uvs;
+	std::vector< std::array<size_t, 4> > bases(chunks.size());
+	size_t totals[4] = {0, 0, 0, 0};
+	for ( size_t i=0; i<chunks.size(); i++ ){
+		bases[i] = {totals[0], totals[1], totals[2], totals[3]};
+		totals[0] += chunks[i].positions.size();
+		totals[1] += chunks[i].uvs.size();
+		totals[2] += chunks[i].normals.size();
+		totals[3] += chunks[i].corners.size();
+	}
+	if ( chunks.size() == 1 ){
+		positions.swap(chunks[0].positions);
+		uvs.swap(chunks[0].uvs);
+		normals.swap(chunks[0].normals);
+	}else{
+		positions.reserve(totals[0]);
+		uvs.reserve(totals[1]);
+		normals.reserve(totals[2]);
+		for ( const Chunk & chunk : chunks ){
+			positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+			uvs.insert(uvs.end(), chunk.uvs.begin(), chunk.uvs.end());
+			normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+		}
 	}
 
-	// For each vertex of each triangle
-	for( unsigned int i=0; i<vertexIndices.size(); i++ ){
-
-		// Get the indices of its attributes
-		unsigned int vertexIndex = vertexIndices[i];
-		unsigned int uvIndex = uvIndices[i];
-		unsigned int normalIndex = normalIndices[i];
-		
-		// Get the attributes thanks to the index
-		glm::vec3 vertex = temp_vertices[ vertexIndex-1 ];
-		glm::vec2 uv = temp_uvs[ uvIndex-1 ];
-		glm::vec3 normal = temp_normals[ normalIndex-1 ];
-		
-		// Put the attributes in buffers
-		out_vertices.push_back(vertex);
-		out_uvs     .push_back(uv);
-		out_normals .push_back(normal);
-	
+	// Resolve: each chunk fills its own slice, so this goes wide too
+	size_t first = out_vertices.size();
+	out_vertices.resize(first + totals[3]);
+	out_uvs     .resize(first + totals[3]);
+	out_normals .resize(first + totals[3]);
+
+	auto emit = [&](size_t i){
+		size_t offset = first + bases[i][3];
+		return emitTriangles(chunks[i], bases[i].data(), positions, uvs, normals,
+		                     &out_vertices[offset], &out_uvs[offset], &out_normals[offset]);
+	};
+	std::vector< std::future<bool> > resolving;
+	for ( size_t i=1; i<chunks.size(); i++ ){
+		resolving.push_back(pool.submit([&, i](){ return emit(i); }));
+	}
+	bool ok = chunks.empty() || emit(0);
+	for ( std::future<bool> & job : resolving ){
+		ok = job.get() && ok;
+	}
+
+	if ( !ok ){
+		printf("File can't be read by our simple parser :-( A face refers to a missing vertex\n");
+		out_vertices.resize(first);
+		out_uvs     .resize(first);
+		out_normals .resize(first);
+		return false;
 	}
-	fclose(file);
 	return true;
 }
 
@@ -3,7 +3,10 @@
 #include <vector>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <algorithm>
+#include <cstdint>
+#include <filesystem>
 using namespace std;
 
 #include <stdlib.h>
@@ -13,83 +16,239 @@ using namespace std;
 
 #include "shader.hpp"
 
-GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path){
+namespace {
 
-	// Create the shaders
-	GLuint VertexShaderID = glCreateShader(GL_VERTEX_SHADER);
-	GLuint FragmentShaderID = glCreateShader(GL_FRAGMENT_SHADER);
+std::string ShaderCacheDirectory = "shadercache";
 
-	// Read the Vertex Shader code from the file
-	std::string VertexShaderCode;
-	std::ifstream VertexShaderStream(vertex_file_path, std::ios::in);
-	if(VertexShaderStream.is_open()){
-		std::string Line = "";
-		while(getline(VertexShaderStream, Line))
-			VertexShaderCode += "\n" + Line;
-		VertexShaderStream.close();
-	}else{
-		printf("Impossible to open %s. Are you in the right directory ? Don't forget to read the FAQ !\n", vertex_file_path);
-		getchar();
-		return 0;
+const char CacheMagic[4] = {'P', 'B', 'S', '2'};
+
+// Reads a whole file in one go; false if it cannot be opened
+bool readFile(const char * path, std::string & out){
+	std::ifstream stream(path, std::ios::in | std::ios::binary);
+	if ( !stream.is_open() ){
+		return false;
 	}
+	std::ostringstream contents;
+	contents << stream.rdbuf();
+	out = contents.str();
+	return true;
+}
 
-	// Read the Fragment Shader code from the file
-	std::string FragmentShaderCode;
-	std::ifstream FragmentShaderStream(fragment_file_path, std::ios::in);
-	if(FragmentShaderStream.is_open()){
-		std::string Line = "";
-		while(getline(FragmentShaderStream, Line))
-			FragmentShaderCode += "\n" + Line;
-		FragmentShaderStream.close();
+// The defines have to follow #version, which must stay the first statement
+std::string injectDefines(const std::string & source, const char * defines){
+	if ( !defines || !*defines ){
+		return source;
+	}
+	size_t version = source.find("#version");
+	if ( version == std::string::npos ){
+		return std::string(defines) + "\n" + source;
+	}
+	size_t lineEnd = source.find('\n', version);
+	if ( lineEnd == std::string::npos ){
+		return source + "\n" + defines + "\n";
 	}
+	return source.substr(0, lineEnd + 1) + defines + "\n" + source.substr(lineEnd + 1);
+}
+
+uint64_t fnv1a(uint64_t hash, const void * data, size_t size){
+	const unsigned char * bytes = (const unsigned char *)data;
+	for ( size_t i=0; i<size; i++ ){
+		hash = (hash ^ bytes[i]) * 1099511628211ull;
+	}
+	return hash;
+}
+
+uint64_t fnv1a(uint64_t hash, const char * text){
+	// Include the terminator so "ab"+"c" and "a"+"bc" differ
+	return text ? fnv1a(hash, text, strlen(text) + 1) : fnv1a(hash, "", 1);
+}
 
+// Names the cache file: one per program, so editing a shader replaces its binary
+// instead of leaving the old one behind
+uint64_t programIdentity(const char * vertexPath, const char * fragmentPath, const char * defines){
+	uint64_t hash = 14695981039346656037ull;
+	hash = fnv1a(hash, vertexPath);
+	hash = fnv1a(hash, fragmentPath);
+	hash = fnv1a(hash, defines);
+	return hash;
+}
+
+// Stored inside the cache file; a binary is only used when this still matches.
+// A new driver may not accept an old binary, so the driver is part of it
+uint64_t programContentHash(const std::string & vertexSource, const std::string & fragmentSource){
+	uint64_t hash = 14695981039346656037ull;
+	hash = fnv1a(hash, vertexSource.c_str());
+	hash = fnv1a(hash, fragmentSource.c_str());
+	hash = fnv1a(hash, (const char *)glGetString(GL_VENDOR));
+	hash = fnv1a(hash, (const char *)glGetString(GL_RENDERER));
+	hash = fnv1a(hash, (const char *)glGetString(GL_VERSION));
+	return hash;
+}
+
+bool programBinariesSupported(){
+	if ( !(GLEW_VERSION_4_1 || GLEW_ARB_get_program_binary) ){
+		return false;
+	}
+	GLint formats = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	return formats > 0;
+}
+
+std::string cachePath(uint64_t identity){
+	char name[32];
+	snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)identity);
+	return ShaderCacheDirectory + "/" + name;
+}
+
+bool linkSucceeded(GLuint ProgramID){
 	GLint Result = GL_FALSE;
-	int InfoLogLength;
+	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+	return Result == GL_TRUE;
+}
 
+// Cache file layout: magic, content hash, binary format, then the driver's binary.
+// Returns 0 on a miss, on a stale binary, or if the driver rejects the stored one
+GLuint loadCachedProgram(uint64_t identity, uint64_t contentHash){
+	std::string blob;
+	const size_t header = sizeof(CacheMagic) + sizeof(uint64_t) + sizeof(GLenum);
+	if ( !readFile(cachePath(identity).c_str(), blob) || blob.size() <= header ||
+	     memcmp(blob.data(), CacheMagic, sizeof(CacheMagic)) != 0 ){
+		return 0;
+	}
+
+	uint64_t storedHash;
+	memcpy(&storedHash, blob.data() + sizeof(CacheMagic), sizeof(storedHash));
+	if ( storedHash != contentHash ){
+		return 0;
+	}
 
-	// Compile Vertex Shader
-	printf("Compiling shader : %s\n", vertex_file_path);
-	char const * VertexSourcePointer = VertexShaderCode.c_str();
-	glShaderSource(VertexShaderID, 1, &VertexSourcePointer , NULL);
-	glCompileShader(VertexShaderID);
+	GLenum format;
+	memcpy(&format, blob.data() + sizeof(CacheMagic) + sizeof(storedHash), sizeof(format));
 
-	// Check Vertex Shader
-	glGetShaderiv(VertexShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(VertexShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
-	if ( InfoLogLength > 0 ){
-		std::vector<char> VertexShaderErrorMessage(InfoLogLength+1);
-		glGetShaderInfoLog(VertexShaderID, InfoLogLength, NULL, &VertexShaderErrorMessage[0]);
-		printf("%s\n", &VertexShaderErrorMessage[0]);
+	GLuint ProgramID = glCreateProgram();
+	glProgramBinary(ProgramID, format, blob.data() + header, (GLsizei)(blob.size() - header));
+	if ( !linkSucceeded(ProgramID) ){
+		glDeleteProgram(ProgramID);
+		return 0;
+	}
+	return ProgramID;
+}
+
+// Overwrites whatever binary this program had before
+void storeCachedProgram(uint64_t identity, uint64_t contentHash, GLuint ProgramID){
+	GLint length = 0;
+	glGetProgramiv(ProgramID, GL_PROGRAM_BINARY_LENGTH, &length);
+	if ( length <= 0 ){
+		return;
 	}
 
+	std::vector<char> binary(length);
+	GLenum format = 0;
+	glGetProgramBinary(ProgramID, length, &length, &format, binary.data());
 
+	std::error_code error;
+	std::filesystem::create_directories(ShaderCacheDirectory, error);
 
-	// Compile Fragment Shader
-	printf("Compiling shader : %s\n", fragment_file_path);
-	char const * FragmentSourcePointer = FragmentShaderCode.c_str();
-	glShaderSource(FragmentShaderID, 1, &FragmentSourcePointer , NULL);
-	glCompileShader(FragmentShaderID);
+	// Write to a temporary name first so a crash never leaves a torn binary behind
+	std::string path = cachePath(identity);
+	std::string temporary = path + ".tmp";
+	FILE * file = fopen(temporary.c_str(), "wb");
+	if ( !file ){
+		return;
+	}
+	bool ok = fwrite(CacheMagic, sizeof(CacheMagic), 1, file) == 1 &&
+	          fwrite(&contentHash, sizeof(contentHash), 1, file) == 1 &&
+	          fwrite(&format, sizeof(format), 1, file) == 1 &&
+	          fwrite(binary.data(), 1, length, file) == (size_t)length;
+	ok = fclose(file) == 0 && ok;
+
+	std::filesystem::rename(temporary, path, error);
+	if ( !ok || error ){
+		std::filesystem::remove(temporary, error);
+	}
+}
+
+// Compiles one stage, printing the log; returns 0 on failure
+GLuint compileShader(GLenum type, const char * path, const std::string & source){
+	GLuint ShaderID = glCreateShader(type);
+
+	printf("Compiling shader : %s\n", path);
+	char const * SourcePointer = source.c_str();
+	glShaderSource(ShaderID, 1, &SourcePointer , NULL);
+	glCompileShader(ShaderID);
 
-	// Check Fragment Shader
-	glGetShaderiv(FragmentShaderID, GL_COMPILE_STATUS, &Result);
-	glGetShaderiv(FragmentShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+	// Check the shader
+	GLint Result = GL_FALSE;
+	int InfoLogLength;
+	glGetShaderiv(ShaderID, GL_COMPILE_STATUS, &Result);
+	glGetShaderiv(ShaderID, GL_INFO_LOG_LENGTH, &InfoLogLength);
 	if ( InfoLogLength > 0 ){
-		std::vector<char> FragmentShaderErrorMessage(InfoLogLength+1);
-		glGetShaderInfoLog(FragmentShaderID, InfoLogLength, NULL, &FragmentShaderErrorMessage[0]);
-		printf("%s\n", &FragmentShaderErrorMessage[0]);
+		std::vector<char> ShaderErrorMessage(InfoLogLength+1);
+		glGetShaderInfoLog(ShaderID, InfoLogLength, NULL, &ShaderErrorMessage[0]);
+		printf("%s\n", &ShaderErrorMessage[0]);
+	}
+
+	if ( Result != GL_TRUE ){
+		glDeleteShader(ShaderID);
+		return 0;
+	}
+	return ShaderID;
+}
+
+} // namespace
+
+void setShaderCacheDirectory(const char * directory){
+	ShaderCacheDirectory = directory ? directory : "";
+}
+
+GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path,const char * defines){
+
+	// Read the shader code from the files
+	std::string VertexShaderCode, FragmentShaderCode;
+	if ( !readFile(vertex_file_path, VertexShaderCode) ){
+		printf("Impossible to open %s. Are you in the right directory ? Don't forget to read the FAQ !\n", vertex_file_path);
+		return 0;
+	}
+	if ( !readFile(fragment_file_path, FragmentShaderCode) ){
+		printf("Impossible to open %s. Are you in the right directory ? Don't forget to read the FAQ !\n", fragment_file_path);
+		return 0;
 	}
+	VertexShaderCode = injectDefines(VertexShaderCode, defines);
+	FragmentShaderCode = injectDefines(FragmentShaderCode, defines);
 
+	// Try the binary cache before compiling anything
+	bool useCache = !ShaderCacheDirectory.empty() && programBinariesSupported();
+	uint64_t identity = 0, contentHash = 0;
+	if ( useCache ){
+		identity = programIdentity(vertex_file_path, fragment_file_path, defines);
+		contentHash = programContentHash(VertexShaderCode, FragmentShaderCode);
+		GLuint ProgramID = loadCachedProgram(identity, contentHash);
+		if ( ProgramID ){
+			return ProgramID;
+		}
+	}
 
+	// Compile both stages
+	GLuint VertexShaderID = compileShader(GL_VERTEX_SHADER, vertex_file_path, VertexShaderCode);
+	GLuint FragmentShaderID = compileShader(GL_FRAGMENT_SHADER, fragment_file_path, FragmentShaderCode);
+	if ( !VertexShaderID || !FragmentShaderID ){
+		glDeleteShader(VertexShaderID);
+		glDeleteShader(FragmentShaderID);
+		return 0;
+	}
 
 	// Link the program
 	printf("Linking program\n");
 	GLuint ProgramID = glCreateProgram();
+	if ( useCache ){
+		glProgramParameteri(ProgramID, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	}
 	glAttachShader(ProgramID, VertexShaderID);
 	glAttachShader(ProgramID, FragmentShaderID);
 	glLinkProgram(ProgramID);
 
 	// Check the program
-	glGetProgramiv(ProgramID, GL_LINK_STATUS, &Result);
+	int InfoLogLength;
 	glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &InfoLogLength);
 	if ( InfoLogLength > 0 ){
 		std::vector<char> ProgramErrorMessage(InfoLogLength+1);
@@ -104,7 +263,53 @@ GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path
 	glDeleteShader(VertexShaderID);
 	glDeleteShader(FragmentShaderID);
 
+	if ( !linkSucceeded(ProgramID) ){
+		glDeleteProgram(ProgramID);
+		return 0;
+	}
+
+	if ( useCache ){
+		storeCachedProgram(identity, contentHash, ProgramID);
+	}
+
 	return ProgramID;
 }
 
+GLuint LoadTransformFeedbackShader(const char * vertex_file_path, const char * const * varyings, int varyingCount, const char * defines){
 
+	std::string VertexShaderCode;
+	if ( !readFile(vertex_file_path, VertexShaderCode) ){
+		printf("Impossible to open %s. Are you in the right directory ? Don't forget to read the FAQ !\n", vertex_file_path);
+		return 0;
+	}
+	VertexShaderCode = injectDefines(VertexShaderCode, defines);
+
+	GLuint VertexShaderID = compileShader(GL_VERTEX_SHADER, vertex_file_path, VertexShaderCode);
+	if ( !VertexShaderID ){
+		return 0;
+	}
+
+	// The captured outputs have to be named before linking
+	printf("Linking program\n");
+	GLuint ProgramID = glCreateProgram();
+	glAttachShader(ProgramID, VertexShaderID);
+	glTransformFeedbackVaryings(ProgramID, varyingCount, varyings, GL_INTERLEAVED_ATTRIBS);
+	glLinkProgram(ProgramID);
+
+	int InfoLogLength;
+	glGetProgramiv(ProgramID, GL_INFO_LOG_LENGTH, &InfoLogLength);
+	if ( InfoLogLength > 0 ){
+		std::vector<char> ProgramErrorMessage(InfoLogLength+1);
+		glGetProgramInfoLog(ProgramID, InfoLogLength, NULL, &ProgramErrorMessage[0]);
+		printf("%s\n", &ProgramErrorMessage[0]);
+	}
+
+	glDetachShader(ProgramID, VertexShaderID);
+	glDeleteShader(VertexShaderID);
+
+	if ( !linkSucceeded(ProgramID) ){
+		glDeleteProgram(ProgramID);
+		return 0;
+	}
+	return ProgramID;
+}
@@ -1,6 +1,20 @@
 #ifndef SHADER_HPP
 #define SHADER_HPP
 
-GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path);
+// Compiles and links a vertex/fragment pair; returns 0 if either stage fails.
+// defines, when given, is inserted after each stage's #version line
+// (e.g. "#define ANALYTIC 1\n"). Linked programs are cached on disk as driver
+// binaries, one file per path pair and defines, so later starts skip compilation
+// entirely; a binary built from other sources or by another driver is rebuilt.
+GLuint LoadShaders(const char * vertex_file_path,const char * fragment_file_path,const char * defines = nullptr);
+
+// Compiles and links a vertex shader on its own for transform feedback: the
+// named outputs are captured interleaved, in order, into the buffer bound to
+// GL_TRANSFORM_FEEDBACK_BUFFER index 0. Not cached. Returns 0 on failure.
+GLuint LoadTransformFeedbackShader(const char * vertex_file_path, const char * const * varyings, int varyingCount, const char * defines = nullptr);
+
+// Where program binaries are kept ("shadercache" under the working directory by
+// default); an empty path turns the cache off
+void setShaderCacheDirectory(const char * directory);
 
 #endif
@@ -1,7 +1,219 @@
+#include <cmath>
 #include <vector>
 #include <glm/glm.hpp>
 
 #include "tangentspace.hpp"
+#include "threadpool.hpp"
+
+#if !defined(POPBALLOONS_NO_SIMD)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define TANGENT_KERNEL_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TANGENT_KERNEL_SSE2
+#endif
+#endif
+
+// The math runs on blocks of W triangles (or vertices) transposed into
+// structure-of-arrays form, so each operation below handles W at once.
+// Operations are ordered exactly as glm's, so every width gives bit-identical
+// results to the original scalar loop.
+
+namespace {
+
+const size_t kMinBatch = 8192; // Triangles per thread batch; smaller batches cost more to hand out than to run
+
+struct Scalar{
+	static const int W = 1;
+	float v;
+	Scalar(float x) : v(x) {}
+	static Scalar load(const float * p){ return Scalar(p[0]); }
+	void store(float * p) const { p[0] = v; }
+	friend Scalar operator+(Scalar a, Scalar b){ return Scalar(a.v + b.v); }
+	friend Scalar operator-(Scalar a, Scalar b){ return Scalar(a.v - b.v); }
+	friend Scalar operator*(Scalar a, Scalar b){ return Scalar(a.v * b.v); }
+	friend Scalar operator/(Scalar a, Scalar b){ return Scalar(a.v / b.v); }
+	friend Scalar sqrt(Scalar a){ return Scalar(std::sqrt(a.v)); }
+	// -value where test < 0, else value
+	friend Scalar negateIfNegative(Scalar value, Scalar test){ return test.v < 0.0f ? Scalar(value.v * -1.0f) : value; }
+};
+
+#if defined(TANGENT_KERNEL_AVX2)
+struct Wide{
+	static const int W = 8;
+	__m256 v;
+	Wide(__m256 x) : v(x) {}
+	Wide(float x) : v(_mm256_set1_ps(x)) {}
+	static Wide load(const float * p){ return Wide(_mm256_loadu_ps(p)); }
+	void store(float * p) const { _mm256_storeu_ps(p, v); }
+	friend Wide operator+(Wide a, Wide b){ return Wide(_mm256_add_ps(a.v, b.v)); }
+	friend Wide operator-(Wide a, Wide b){ return Wide(_mm256_sub_ps(a.v, b.v)); }
+	friend Wide operator*(Wide a, Wide b){ return Wide(_mm256_mul_ps(a.v, b.v)); }
+	friend Wide operator/(Wide a, Wide b){ return Wide(_mm256_div_ps(a.v, b.v)); }
+	friend Wide sqrt(Wide a){ return Wide(_mm256_sqrt_ps(a.v)); }
+	friend Wide negateIfNegative(Wide value, Wide test){
+		__m256 negative = _mm256_cmp_ps(test.v, _mm256_setzero_ps(), _CMP_LT_OQ);
+		return Wide(_mm256_xor_ps(value.v, _mm256_and_ps(negative, _mm256_set1_ps(-0.0f))));
+	}
+};
+#elif defined(TANGENT_KERNEL_SSE2)
+struct Wide{
+	static const int W = 4;
+	__m128 v;
+	Wide(__m128 x) : v(x) {}
+	Wide(float x) : v(_mm_set1_ps(x)) {}
+	static Wide load(const float * p){ return Wide(_mm_loadu_ps(p)); }
+	void store(float * p) const { _mm_storeu_ps(p, v); }
+	friend Wide operator+(Wide a, Wide b){ return Wide(_mm_add_ps(a.v, b.v)); }
+	friend Wide operator-(Wide a, Wide b){ return Wide(_mm_sub_ps(a.v, b.v)); }
+	friend Wide operator*(Wide a, Wide b){ return Wide(_mm_mul_ps(a.v, b.v)); }
+	friend Wide operator/(Wide a, Wide b){ return Wide(_mm_div_ps(a.v, b.v)); }
+	friend Wide sqrt(Wide a){ return Wide(_mm_sqrt_ps(a.v)); }
+	friend Wide negateIfNegative(Wide value, Wide test){
+		__m128 negative = _mm_cmplt_ps(test.v, _mm_setzero_ps());
+		return Wide(_mm_xor_ps(value.v, _mm_and_ps(negative, _mm_set1_ps(-0.0f))));
+	}
+};
+#else
+typedef Scalar Wide;
+#endif
+
+template <typename P>
+struct Vec3{
+	P x, y, z;
+};
+
+template <typename P>
+Vec3<P> loadVec3(const float (*block)[Wide::W], int first){
+	return Vec3<P>{ P::load(block[first]), P::load(block[first + 1]), P::load(block[first + 2]) };
+}
+
+template <typename P>
+void storeVec3(const Vec3<P> & v, float (*block)[Wide::W], int first){
+	v.x.store(block[first]); v.y.store(block[first + 1]); v.z.store(block[first + 2]);
+}
+
+template <typename P>
+P dot(const Vec3<P> & a, const Vec3<P> & b){
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+// Triangle block layout: v0 v1 v2 (0-8), uv0 uv1 uv2 (9-14) in; tangent (0-2), bitangent (3-5) out
+template <typename P>
+void triangleKernel(const float (*in)[Wide::W], float (*out)[Wide::W]){
+	Vec3<P> v0 = loadVec3<P>(in, 0), v1 = loadVec3<P>(in, 3), v2 = loadVec3<P>(in, 6);
+	P u0x = P::load(in[9]),  u0y = P::load(in[10]);
+	P u1x = P::load(in[11]), u1y = P::load(in[12]);
+	P u2x = P::load(in[13]), u2y = P::load(in[14]);
+
+	// Edges of the triangle : postion delta
+	Vec3<P> deltaPos1 = { v1.x - v0.x, v1.y - v0.y, v1.z - v0.z };
+	Vec3<P> deltaPos2 = { v2.x - v0.x, v2.y - v0.y, v2.z - v0.z };
+
+	// UV delta
+	P deltaUV1x = u1x - u0x, deltaUV1y = u1y - u0y;
+	P deltaUV2x = u2x - u0x, deltaUV2y = u2y - u0y;
+
+	P r = P(1.0f) / (deltaUV1x * deltaUV2y - deltaUV1y * deltaUV2x);
+	Vec3<P> tangent = {
+		(deltaPos1.x * deltaUV2y - deltaPos2.x * deltaUV1y) * r,
+		(deltaPos1.y * deltaUV2y - deltaPos2.y * deltaUV1y) * r,
+		(deltaPos1.z * deltaUV2y - deltaPos2.z * deltaUV1y) * r };
+	Vec3<P> bitangent = {
+		(deltaPos2.x * deltaUV1x - deltaPos1.x * deltaUV2x) * r,
+		(deltaPos2.y * deltaUV1x - deltaPos1.y * deltaUV2x) * r,
+		(deltaPos2.z * deltaUV1x - deltaPos1.z * deltaUV2x) * r };
+
+	storeVec3(tangent, out, 0);
+	storeVec3(bitangent, out, 3);
+}
+
+// Vertex block layout: normal (0-2), tangent (3-5), bitangent (6-8) in; tangent (0-2) out
+template <typename P>
+void orthogonalizeKernel(const float (*in)[Wide::W], float (*out)[Wide::W]){
+	Vec3<P> n = loadVec3<P>(in, 0), t = loadVec3<P>(in, 3), b = loadVec3<P>(in, 6);
+
+	// Gram-Schmidt orthogonalize
+	P nt = dot(n, t);
+	t = Vec3<P>{ t.x - n.x * nt, t.y - n.y * nt, t.z - n.z * nt };
+	P inverseLength = P(1.0f) / sqrt(dot(t, t));
+	t = Vec3<P>{ t.x * inverseLength, t.y * inverseLength, t.z * inverseLength };
+
+	// Calculate handedness
+	Vec3<P> c = { n.y * t.z - t.y * n.z, n.z * t.x - t.z * n.x, n.x * t.y - t.x * n.y };
+	P handedness = dot(c, b);
+	t = Vec3<P>{ negateIfNegative(t.x, handedness), negateIfNegative(t.y, handedness), negateIfNegative(t.z, handedness) };
+
+	storeVec3(t, out, 0);
+}
+
+// Runs kernel over items [begin, end): gather(item, lane, block) transposes one item in,
+// scatter(item, lane, block) writes one result out. Full blocks go wide, the tail goes scalar.
+template <int Inputs, int Outputs, typename Gather, typename Scatter, typename WideKernel, typename ScalarKernel>
+void runBlocks(size_t begin, size_t end, Gather gather, Scatter scatter, WideKernel wideKernel, ScalarKernel scalarKernel){
+	float in[Inputs][Wide::W];
+	float out[Outputs][Wide::W];
+
+	size_t i = begin;
+	for ( ; i + Wide::W <= end; i += Wide::W ){
+		for ( int lane=0; lane<Wide::W; lane++ ){
+			gather(i + lane, lane, in);
+		}
+		wideKernel(in, out);
+		for ( int lane=0; lane<Wide::W; lane++ ){
+			scatter(i + lane, lane, out);
+		}
+	}
+	for ( ; i < end; i++ ){
+		gather(i, 0, in);
+		scalarKernel(in, out);
+		scatter(i, 0, out);
+	}
+}
+
+inline void put(float (*block)[Wide::W], int first, int lane, const glm::vec3 & v){
+	block[first][lane] = v.x; block[first + 1][lane] = v.y; block[first + 2][lane] = v.z;
+}
+
+inline glm::vec3 get(const float (*block)[Wide::W], int first, int lane){
+	return glm::vec3(block[first][lane], block[first + 1][lane], block[first + 2][lane]);
+}
+
+// Tangent and bitangent of every triangle whose corners corner(t, k) returns,
+// handed to store(t, tangent, bitangent)
+template <typename Corner, typename Store>
+void triangleTangents(size_t begin, size_t end, Corner corner, Store store,
+                      const glm::vec3 * vertices, const glm::vec2 * uvs){
+	runBlocks<15, 6>(begin, end,
+		[&](size_t t, int lane, float (*in)[Wide::W]){
+			for ( int k=0; k<3; k++ ){
+				size_t v = corner(t, k);
+				put(in, 3 * k, lane, vertices[v]);
+				in[9 + 2 * k][lane] = uvs[v].x;
+				in[10 + 2 * k][lane] = uvs[v].y;
+			}
+		},
+		[&](size_t t, int lane, const float (*out)[Wide::W]){
+			store(t, get(out, 0, lane), get(out, 3, lane));
+		},
+		triangleKernel<Wide>, triangleKernel<Scalar>);
+}
+
+void orthogonalize(size_t begin, size_t end, const glm::vec3 * normals, glm::vec3 * tangents, const glm::vec3 * bitangents){
+	runBlocks<9, 3>(begin, end,
+		[&](size_t v, int lane, float (*in)[Wide::W]){
+			put(in, 0, lane, normals[v]);
+			put(in, 3, lane, tangents[v]);
+			put(in, 6, lane, bitangents[v]);
+		},
+		[&](size_t v, int lane, const float (*out)[Wide::W]){
+			tangents[v] = get(out, 0, lane);
+		},
+		orthogonalizeKernel<Wide>, orthogonalizeKernel<Scalar>);
+}
+
+} // namespace
 
 void computeTangentBasis(
 	// inputs
@@ -12,62 +224,64 @@ void computeTangentBasis(
 	std::vector<glm::vec3> & tangents,
 	std::vector<glm::vec3> & bitangents
 ){
+	const size_t triangleCount = vertices.size() / 3;
+	tangents.resize(triangleCount * 3);
+	bitangents.resize(triangleCount * 3);
 
-	for (unsigned int i=0; i<vertices.size(); i+=3 ){
-
-		// Shortcuts for vertices
-		glm::vec3 & v0 = vertices[i+0];
-		glm::vec3 & v1 = vertices[i+1];
-		glm::vec3 & v2 = vertices[i+2];
-
-		// Shortcuts for UVs
-		glm::vec2 & uv0 = uvs[i+0];
-		glm::vec2 & uv1 = uvs[i+1];
-		glm::vec2 & uv2 = uvs[i+2];
-
-		// Edges of the triangle : postion delta
-		glm::vec3 deltaPos1 = v1-v0;
-		glm::vec3 deltaPos2 = v2-v0;
-
-		// UV delta
-		glm::vec2 deltaUV1 = uv1-uv0;
-		glm::vec2 deltaUV2 = uv2-uv0;
-
-		float r = 1.0f / (deltaUV1.x * deltaUV2.y - deltaUV1.y * deltaUV2.x);
-		glm::vec3 tangent = (deltaPos1 * deltaUV2.y   - deltaPos2 * deltaUV1.y)*r;
-		glm::vec3 bitangent = (deltaPos2 * deltaUV1.x   - deltaPos1 * deltaUV2.x)*r;
-
+	ThreadPool::shared().parallelFor(triangleCount, kMinBatch, [&](size_t begin, size_t end){
 		// Set the same tangent for all three vertices of the triangle.
 		// They will be merged later, in vboindexer.cpp
-		tangents.push_back(tangent);
-		tangents.push_back(tangent);
-		tangents.push_back(tangent);
+		triangleTangents(begin, end,
+			[](size_t t, int k){ return 3 * t + k; },
+			[&](size_t t, const glm::vec3 & tangent, const glm::vec3 & bitangent){
+				for ( int k=0; k<3; k++ ){
+					tangents[3 * t + k] = tangent;
+					bitangents[3 * t + k] = bitangent;
+				}
+			},
+			vertices.data(), uvs.data());
 
-		// Same thing for binormals
-		bitangents.push_back(bitangent);
-		bitangents.push_back(bitangent);
-		bitangents.push_back(bitangent);
+		// See "Going Further"
+		orthogonalize(3 * begin, 3 * end, normals.data(), tangents.data(), bitangents.data());
+	});
+}
 
-	}
+void computeTangentBasisIndexed(
+	// inputs
+	const std::vector<unsigned int> & indices,
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	// outputs
+	std::vector<glm::vec3> & tangents,
+	std::vector<glm::vec3> & bitangents
+){
+	const size_t triangleCount = indices.size() / 3;
+	std::vector<glm::vec3> triangleTangent(triangleCount), triangleBitangent(triangleCount);
 
-	// See "Going Further"
-	for (unsigned int i=0; i<vertices.size(); i+=1 )
-	{
-		glm::vec3 & n = normals[i];
-		glm::vec3 & t = tangents[i];
-		glm::vec3 & b = bitangents[i];
-		
-		// Gram-Schmidt orthogonalize
-		t = glm::normalize(t - n * glm::dot(n, t));
-		
-		// Calculate handedness
-		if (glm::dot(glm::cross(n, t), b) < 0.0f){
-			t = t * -1.0f;
-		}
+	ThreadPool & pool = ThreadPool::shared();
+	pool.parallelFor(triangleCount, kMinBatch, [&](size_t begin, size_t end){
+		triangleTangents(begin, end,
+			[&](size_t t, int k){ return (size_t)indices[3 * t + k]; },
+			[&](size_t t, const glm::vec3 & tangent, const glm::vec3 & bitangent){
+				triangleTangent[t] = tangent;
+				triangleBitangent[t] = bitangent;
+			},
+			vertices.data(), uvs.data());
+	});
 
+	// Scatter-add in triangle order, so the sums do not depend on the thread count
+	tangents.assign(vertices.size(), glm::vec3(0.0f));
+	bitangents.assign(vertices.size(), glm::vec3(0.0f));
+	for ( size_t t=0; t<triangleCount; t++ ){
+		for ( int k=0; k<3; k++ ){
+			unsigned int v = indices[3 * t + k];
+			tangents[v] += triangleTangent[t];
+			bitangents[v] += triangleBitangent[t];
+		}
 	}
 
-
+	pool.parallelFor(vertices.size(), kMinBatch, [&](size_t begin, size_t end){
+		orthogonalize(begin, end, normals.data(), tangents.data(), bitangents.data());
+	});
 }
-
-
@@ -1,6 +1,12 @@
 #ifndef TANGENTSPACE_HPP
 #define TANGENTSPACE_HPP
 
+#include <vector>
+#include <glm/glm.hpp>
+
+// Per-vertex tangents and bitangents for an unindexed triangle list.
+// Every corner gets its triangle's tangent, Gram-Schmidt orthogonalized
+// against the corner's normal; corners are merged later by indexVBO_TBN.
 void computeTangentBasis(
 	// inputs
 	std::vector<glm::vec3> & vertices,
@@ -11,5 +17,19 @@ void computeTangentBasis(
 	std::vector<glm::vec3> & bitangents
 );
 
+// Same basis for an already indexed mesh: each vertex sums the tangents and
+// bitangents of every triangle that uses it, then the summed tangent is
+// orthogonalized once. Replaces computeTangentBasis + indexVBO_TBN's averaging.
+void computeTangentBasisIndexed(
+	// inputs
+	const std::vector<unsigned int> & indices,
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	// outputs
+	std::vector<glm::vec3> & tangents,
+	std::vector<glm::vec3> & bitangents
+);
+
 
-#endif
\ No newline at end of file
+#endif
@@ -1,5 +1,6 @@
 #include <vector>
 #include <cstring>
+#include <cstddef>
 
 #include <GL/glew.h>
 
@@ -12,20 +13,67 @@ using namespace glm;
 
 #include "text2D.hpp"
 
+// One vertex of a glyph quad, position and UV interleaved
+struct TextVertex {
+	glm::vec2 position;
+	glm::vec2 uv;
+};
+
 unsigned int Text2DTextureID;
+unsigned int Text2DVertexArrayID;
 unsigned int Text2DVertexBufferID;
-unsigned int Text2DUVBufferID;
 unsigned int Text2DShaderID;
 unsigned int Text2DUniformID;
 
+// Capacity of Text2DVertexBufferID, in vertices
+size_t Text2DBufferCapacity = 0;
+
+// Every string printed since the last flush
+std::vector<TextVertex> Text2DBatch;
+
+// The two triangles of a glyph, as corners of the unit quad (x right, y up).
+// The UV of each corner is the font cell's top left plus the same corner flipped in y.
+const glm::vec2 GlyphCorners[6] = {
+	glm::vec2(0.0f, 1.0f), glm::vec2(0.0f, 0.0f), glm::vec2(1.0f, 1.0f),
+	glm::vec2(1.0f, 0.0f), glm::vec2(1.0f, 1.0f), glm::vec2(0.0f, 0.0f),
+};
+
+// Per character UVs of the six glyph vertices in the 16x16 font texture
+glm::vec2 GlyphUVs[256][6];
+
 void initText2D(const char * texturePath){
 
 	// Initialize texture
 	Text2DTextureID = loadDDS(texturePath);
 
-	// Initialize VBO
+	// Precompute the glyph quads' UVs
+	for ( int character=0; character<256; character++ ){
+		float uv_x = (character%16)/16.0f;
+		float uv_y = (character/16)/16.0f;
+		for ( int corner=0; corner<6; corner++ ){
+			GlyphUVs[character][corner] = glm::vec2( uv_x + GlyphCorners[corner].x/16.0f,
+			                                         uv_y + (1.0f - GlyphCorners[corner].y)/16.0f );
+		}
+	}
+
+	// Initialize VBO, with the interleaved layout recorded once in its own VAO
+	glGenVertexArrays(1, &Text2DVertexArrayID);
+	glBindVertexArray(Text2DVertexArrayID);
 	glGenBuffers(1, &Text2DVertexBufferID);
-	glGenBuffers(1, &Text2DUVBufferID);
+	glBindBuffer(GL_ARRAY_BUFFER, Text2DVertexBufferID);
+
+	// 1rst attribute : vertices
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, position) );
+
+	// 2nd attribute : UVs
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, sizeof(TextVertex), (void*)offsetof(TextVertex, uv) );
+
+	glBindVertexArray(0);
+
+	Text2DBufferCapacity = 0;
+	Text2DBatch.reserve(6 * 256);
 
 	// Initialize Shader
 	Text2DShaderID = LoadShaders( "TextVertexShader.vertexshader", "TextVertexShader.fragmentshader" );
@@ -37,46 +85,36 @@ void initText2D(const char * texturePath){
 
 void printText2D(const char * text, int x, int y, int size){
 
-	unsigned int length = strlen(text);
-
-	// Fill buffers
-	std::vector<glm::vec2> vertices;
-	std::vector<glm::vec2> UVs;
-	for ( unsigned int i=0 ; i<length ; i++ ){
-		
-		glm::vec2 vertex_up_left    = glm::vec2( x+i*size     , y+size );
-		glm::vec2 vertex_up_right   = glm::vec2( x+i*size+size, y+size );
-		glm::vec2 vertex_down_right = glm::vec2( x+i*size+size, y      );
-		glm::vec2 vertex_down_left  = glm::vec2( x+i*size     , y      );
-
-		vertices.push_back(vertex_up_left   );
-		vertices.push_back(vertex_down_left );
-		vertices.push_back(vertex_up_right  );
+	size_t length = strlen(text);
+	size_t first = Text2DBatch.size();
+	Text2DBatch.resize(first + 6 * length);
+
+	// Fill the batch; it keeps its capacity across frames, so this does not allocate once warmed up
+	TextVertex * vertex = &Text2DBatch[first];
+	for ( size_t i=0 ; i<length ; i++ ){
+		glm::vec2 origin( x + (float)i*size, y );
+		const glm::vec2 * uvs = GlyphUVs[(unsigned char)text[i]];
+		for ( int corner=0; corner<6; corner++ ){
+			vertex->position = origin + GlyphCorners[corner] * (float)size;
+			vertex->uv = uvs[corner];
+			vertex++;
+		}
+	}
+}
 
-		vertices.push_back(vertex_down_right);
-		vertices.push_back(vertex_up_right);
-		vertices.push_back(vertex_down_left);
+void flushText2D(){
 
-		char character = text[i];
-		float uv_x = (character%16)/16.0f;
-		float uv_y = (character/16)/16.0f;
+	if ( Text2DBatch.empty() )
+		return;
 
-		glm::vec2 uv_up_left    = glm::vec2( uv_x           , uv_y );
-		glm::vec2 uv_up_right   = glm::vec2( uv_x+1.0f/16.0f, uv_y );
-		glm::vec2 uv_down_right = glm::vec2( uv_x+1.0f/16.0f, (uv_y + 1.0f/16.0f) );
-		glm::vec2 uv_down_left  = glm::vec2( uv_x           , (uv_y + 1.0f/16.0f) );
-		UVs.push_back(uv_up_left   );
-		UVs.push_back(uv_down_left );
-		UVs.push_back(uv_up_right  );
-
-		UVs.push_back(uv_down_right);
-		UVs.push_back(uv_up_right);
-		UVs.push_back(uv_down_left);
-	}
+	// Orphan the previous frame's storage so the driver need not wait for it to be drawn,
+	// growing only when the batch outgrows it
 	glBindBuffer(GL_ARRAY_BUFFER, Text2DVertexBufferID);
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(glm::vec2), &vertices[0], GL_STATIC_DRAW);
-	glBindBuffer(GL_ARRAY_BUFFER, Text2DUVBufferID);
-	glBufferData(GL_ARRAY_BUFFER, UVs.size() * sizeof(glm::vec2), &UVs[0], GL_STATIC_DRAW);
+	if ( Text2DBatch.size() > Text2DBufferCapacity ){
+		Text2DBufferCapacity = Text2DBatch.capacity();
+	}
+	glBufferData(GL_ARRAY_BUFFER, Text2DBufferCapacity * sizeof(TextVertex), NULL, GL_STREAM_DRAW);
+	glBufferSubData(GL_ARRAY_BUFFER, 0, Text2DBatch.size() * sizeof(TextVertex), &Text2DBatch[0]);
 
 	// Bind shader
 	glUseProgram(Text2DShaderID);
@@ -87,34 +125,26 @@ void printText2D(const char * text, int x, int y, int size){
 	// Set our "myTextureSampler" sampler to use Texture Unit 0
 	glUniform1i(Text2DUniformID, 0);
 
-	// 1rst attribute buffer : vertices
-	glEnableVertexAttribArray(0);
-	glBindBuffer(GL_ARRAY_BUFFER, Text2DVertexBufferID);
-	glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, (void*)0 );
-
-	// 2nd attribute buffer : UVs
-	glEnableVertexAttribArray(1);
-	glBindBuffer(GL_ARRAY_BUFFER, Text2DUVBufferID);
-	glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 0, (void*)0 );
-
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	// Draw call
-	glDrawArrays(GL_TRIANGLES, 0, vertices.size() );
+	glBindVertexArray(Text2DVertexArrayID);
+	glDrawArrays(GL_TRIANGLES, 0, (GLsizei)Text2DBatch.size() );
+	glBindVertexArray(0);
 
 	glDisable(GL_BLEND);
 
-	glDisableVertexAttribArray(0);
-	glDisableVertexAttribArray(1);
-
+	Text2DBatch.clear();
 }
 
 void cleanupText2D(){
 
 	// Delete buffers
 	glDeleteBuffers(1, &Text2DVertexBufferID);
-	glDeleteBuffers(1, &Text2DUVBufferID);
+	glDeleteVertexArrays(1, &Text2DVertexArrayID);
+	Text2DBatch.clear();
+	Text2DBatch.shrink_to_fit();
 
 	// Delete texture
 	glDeleteTextures(1, &Text2DTextureID);
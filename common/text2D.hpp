@@ -2,7 +2,10 @@
 #define TEXT2D_HPP
 
 void initText2D(const char * texturePath);
+// Queues a string; nothing is drawn until flushText2D
 void printText2D(const char * text, int x, int y, int size);
+// Draws every string queued since the last flush in one draw call
+void flushText2D();
 void cleanupText2D();
 
-#endif
\ No newline at end of file
+#endif
@@ -6,8 +6,10 @@
 
 #include <glfw3.h>
 
+#include "texture.hpp"
 
-GLuint loadBMP_custom(const char * imagepath){
+
+bool readBMP(const char * imagepath, TextureImage & image){
 
 	printf("Reading image %s\n", imagepath);
 
@@ -16,15 +18,12 @@ GLuint loadBMP_custom(const char * imagepath){
 	unsigned int dataPos;
 	unsigned int imageSize;
 	unsigned int width, height;
-	// Actual RGB data
-	unsigned char * data;
 
 	// Open the file
 	FILE * file = fopen(imagepath,"rb");
 	if (!file){
 		printf("%s could not be opened. Are you in the right directory ? Don't forget to read the FAQ !\n", imagepath);
-		getchar();
-		return 0;
+		return false;
 	}
 
 	// Read the header, i.e. the 54 first bytes
@@ -33,17 +32,17 @@ GLuint loadBMP_custom(const char * imagepath){
 	if ( fread(header, 1, 54, file)!=54 ){ 
 		printf("Not a correct BMP file\n");
 		fclose(file);
-		return 0;
+		return false;
 	}
 	// A BMP files always begins with "BM"
 	if ( header[0]!='B' || header[1]!='M' ){
 		printf("Not a correct BMP file\n");
 		fclose(file);
-		return 0;
+		return false;
 	}
 	// Make sure this is a 24bpp file
-	if ( *(int*)&(header[0x1E])!=0  )         {printf("Not a correct BMP file\n");    fclose(file); return 0;}
-	if ( *(int*)&(header[0x1C])!=24 )         {printf("Not a correct BMP file\n");    fclose(file); return 0;}
+	if ( *(int*)&(header[0x1E])!=0  )         {printf("Not a correct BMP file\n");    fclose(file); return false;}
+	if ( *(int*)&(header[0x1C])!=24 )         {printf("Not a correct BMP file\n");    fclose(file); return false;}
 
 	// Read the information about the image
 	dataPos    = *(int*)&(header[0x0A]);
@@ -51,19 +50,50 @@ GLuint loadBMP_custom(const char * imagepath){
 	width      = *(int*)&(header[0x12]);
 	height     = *(int*)&(header[0x16]);
 
+	// Rows are padded to 4 bytes, which matches GL's default unpack alignment
+	unsigned int rowSize = (width * 3 + 3) & ~3u;
+	if ( width == 0 || height == 0 || width > 16384 || height > 16384 ){
+		printf("%s has an unsupported size %ux%u\n", imagepath, width, height);
+		fclose(file);
+		return false;
+	}
+
 	// Some BMP files are misformatted, guess missing information
-	if (imageSize==0)    imageSize=width*height*3; // 3 : one byte for each Red, Green and Blue component
+	if (imageSize==0)    imageSize=rowSize*height; // 3 : one byte for each Red, Green and Blue component, rows padded
 	if (dataPos==0)      dataPos=54; // The BMP header is done that way
-
-	// Create a buffer
-	data = new unsigned char [imageSize];
+	if ( imageSize < rowSize*height ){
+		printf("%s is truncated\n", imagepath);
+		fclose(file);
+		return false;
+	}
 
 	// Read the actual data from the file into the buffer
-	fread(data,1,imageSize,file);
+	image.data.resize(imageSize);
+	bool complete = fseek(file, dataPos, SEEK_SET) == 0 && fread(image.data.data(), 1, imageSize, file) == imageSize;
 
 	// Everything is in memory now, the file can be closed.
 	fclose (file);
 
+	if ( !complete ){
+		printf("%s is truncated\n", imagepath);
+		image.data.clear();
+		return false;
+	}
+
+	image.width = width;
+	image.height = height;
+	image.levelCount = 1;
+	image.format = GL_BGR;
+	image.compressed = false;
+	return true;
+}
+
+GLuint loadBMP_custom(const char * imagepath){
+	TextureImage image;
+	if ( !readBMP(imagepath, image) ){
+		return 0;
+	}
+
 	// Create one OpenGL texture
 	GLuint textureID;
 	glGenTextures(1, &textureID);
@@ -72,22 +102,7 @@ GLuint loadBMP_custom(const char * imagepath){
 	glBindTexture(GL_TEXTURE_2D, textureID);
 
 	// Give the image to OpenGL
-	glTexImage2D(GL_TEXTURE_2D, 0,GL_RGB, width, height, 0, GL_BGR, GL_UNSIGNED_BYTE, data);
-
-	// OpenGL has now copied the data. Free our own version
-	delete [] data;
-
-	// Poor filtering, or ...
-	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-	//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); 
-
-	// ... nice trilinear filtering ...
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-	// ... which requires mipmaps. Generate them automatically.
-	glGenerateMipmap(GL_TEXTURE_2D);
+	uploadTextureImage(image, image.data.data());
 
 	// Return the ID of the texture we just created
 	return textureID;
@@ -124,7 +139,11 @@ GLuint loadBMP_custom(const char * imagepath){
 #define FOURCC_DXT3 0x33545844 // Equivalent to "DXT3" in ASCII
 #define FOURCC_DXT5 0x35545844 // Equivalent to "DXT5" in ASCII
 
-GLuint loadDDS(const char * imagepath){
+static unsigned int blockSizeOf(GLenum format){
+	return (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16;
+}
+
+bool readDDS(const char * imagepath, TextureImage & image){
 
 	unsigned char header[124];
 
@@ -133,38 +152,30 @@ GLuint loadDDS(const char * imagepath){
 	/* try to open the file */ 
 	fp = fopen(imagepath, "rb"); 
 	if (fp == NULL){
-		printf("%s could not be opened. Are you in the right directory ? Don't forget to read the FAQ !\n", imagepath); getchar(); 
-		return 0;
+		printf("%s could not be opened. Are you in the right directory ? Don't forget to read the FAQ !\n", imagepath);
+		return false;
 	}
    
 	/* verify the type of file */ 
 	char filecode[4]; 
-	fread(filecode, 1, 4, fp); 
-	if (strncmp(filecode, "DDS ", 4) != 0) { 
+	if (fread(filecode, 1, 4, fp) != 4 || strncmp(filecode, "DDS ", 4) != 0) { 
+		printf("%s is not a DDS file\n", imagepath);
 		fclose(fp); 
-		return 0; 
+		return false; 
 	}
 	
 	/* get the surface desc */ 
-	fread(&header, 124, 1, fp); 
+	if (fread(&header, 124, 1, fp) != 1) {
+		printf("%s is truncated\n", imagepath);
+		fclose(fp);
+		return false;
+	}
 
 	unsigned int height      = *(unsigned int*)&(header[8 ]);
 	unsigned int width	     = *(unsigned int*)&(header[12]);
-	unsigned int linearSize	 = *(unsigned int*)&(header[16]);
 	unsigned int mipMapCount = *(unsigned int*)&(header[24]);
 	unsigned int fourCC      = *(unsigned int*)&(header[80]);
 
- 
-	unsigned char * buffer;
-	unsigned int bufsize;
-	/* how big is it going to be including all mipmaps? */ 
-	bufsize = mipMapCount > 1 ? linearSize * 2 : linearSize; 
-	buffer = (unsigned char*)malloc(bufsize * sizeof(unsigned char)); 
-	fread(buffer, 1, bufsize, fp); 
-	/* close the file pointer */ 
-	fclose(fp);
-
-	unsigned int components  = (fourCC == FOURCC_DXT1) ? 3 : 4; 
 	unsigned int format;
 	switch(fourCC) 
 	{ 
@@ -178,27 +189,100 @@ GLuint loadDDS(const char * imagepath){
 		format = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT; 
 		break; 
 	default: 
-		free(buffer); 
-		return 0; 
+		printf("%s is not DXT1, DXT3 or DXT5 compressed\n", imagepath);
+		fclose(fp);
+		return false; 
 	}
 
-	// Create one OpenGL texture
-	GLuint textureID;
-	glGenTextures(1, &textureID);
+	if ( width == 0 || height == 0 || width > 16384 || height > 16384 ){
+		printf("%s has an unsupported size %ux%u\n", imagepath, width, height);
+		fclose(fp);
+		return false;
+	}
+	if ( mipMapCount == 0 ) mipMapCount = 1; // Files without mipmaps may leave the count at zero
+	if ( mipMapCount > 15 ) mipMapCount = 15; // 16384 has 15 levels
+
+	/* how big is it going to be including all mipmaps? */ 
+	unsigned int bufsize = 0;
+	unsigned int w = width, h = height;
+	for (unsigned int level = 0; level < mipMapCount; ++level) {
+		bufsize += ((w+3)/4)*((h+3)/4)*blockSizeOf(format);
+		w = w > 1 ? w/2 : 1;
+		h = h > 1 ? h/2 : 1;
+	}
+	image.data.resize(bufsize);
+	bool complete = fread(image.data.data(), 1, bufsize, fp) == bufsize;
+	/* close the file pointer */ 
+	fclose(fp);
+
+	if ( !complete ){
+		printf("%s is truncated\n", imagepath);
+		image.data.clear();
+		return false;
+	}
+
+	image.width = width;
+	image.height = height;
+	image.levelCount = mipMapCount;
+	image.format = format;
+	image.compressed = true;
+	return true;
+}
+
+bool readTextureImage(const char * imagepath, TextureImage & image){
+	FILE * file = fopen(imagepath, "rb");
+	if ( !file ){
+		printf("%s could not be opened. Are you in the right directory ? Don't forget to read the FAQ !\n", imagepath);
+		return false;
+	}
+	char magic[4] = {0, 0, 0, 0};
+	size_t count = fread(magic, 1, 4, file);
+	fclose(file);
+
+	if ( count == 4 && strncmp(magic, "DDS ", 4) == 0 ){
+		return readDDS(imagepath, image);
+	}
+	if ( count >= 2 && magic[0] == 'B' && magic[1] == 'M' ){
+		return readBMP(imagepath, image);
+	}
+	printf("%s is neither a BMP nor a DDS file\n", imagepath);
+	return false;
+}
+
+void uploadTextureImage(const TextureImage & image, const void * pixels){
+	const unsigned char * base = (const unsigned char *)pixels;
+
+	if ( !image.compressed ){
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4); // BMP rows are padded to 4 bytes
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, image.width, image.height, 0, image.format, GL_UNSIGNED_BYTE, base);
+
+		// Poor filtering, or ...
+		//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		//glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST); 
+
+		// ... nice trilinear filtering ...
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		// ... which requires mipmaps. Generate them automatically.
+		glGenerateMipmap(GL_TEXTURE_2D);
+		return;
+	}
 
-	// "Bind" the newly created texture : all future texture functions will modify this texture
-	glBindTexture(GL_TEXTURE_2D, textureID);
 	glPixelStorei(GL_UNPACK_ALIGNMENT,1);	
 	
-	unsigned int blockSize = (format == GL_COMPRESSED_RGBA_S3TC_DXT1_EXT) ? 8 : 16; 
+	unsigned int blockSize = blockSizeOf(image.format); 
 	unsigned int offset = 0;
+	unsigned int width = image.width;
+	unsigned int height = image.height;
 
 	/* load the mipmaps */ 
-	for (unsigned int level = 0; level < mipMapCount && (width || height); ++level) 
+	for (unsigned int level = 0; level < image.levelCount; ++level) 
 	{ 
 		unsigned int size = ((width+3)/4)*((height+3)/4)*blockSize; 
-		glCompressedTexImage2D(GL_TEXTURE_2D, level, format, width, height,  
-			0, size, buffer + offset); 
+		glCompressedTexImage2D(GL_TEXTURE_2D, level, image.format, width, height,  
+			0, size, base + offset); 
 	 
 		offset += size; 
 		width  /= 2; 
@@ -210,9 +294,23 @@ GLuint loadDDS(const char * imagepath){
 
 	} 
 
-	free(buffer); 
+	// Stop sampling at the last level the file provides
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, image.levelCount - 1);
+}
 
-	return textureID;
+GLuint loadDDS(const char * imagepath){
+	TextureImage image;
+	if ( !readDDS(imagepath, image) ){
+		return 0;
+	}
 
+	// Create one OpenGL texture
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+
+	// "Bind" the newly created texture : all future texture functions will modify this texture
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	uploadTextureImage(image, image.data.data());
 
-}
\ No newline at end of file
+	return textureID;
+}
@@ -1,6 +1,29 @@
 #ifndef TEXTURE_HPP
 #define TEXTURE_HPP
 
+#include <vector>
+
+// A texture file read and validated on the CPU, ready to hand to GL.
+// Reading touches no GL state, so it can run on any thread.
+struct TextureImage {
+	unsigned int width;
+	unsigned int height;
+	unsigned int levelCount; // Mip levels stored in data (DDS), or 1
+	GLenum       format;     // GL_BGR for BMP, an S3TC format for DDS
+	bool         compressed;
+	std::vector<unsigned char> data;
+};
+
+// Read a .BMP (24bpp, uncompressed) or a DXT1/3/5 .DDS file; false with a message on failure
+bool readBMP(const char * imagepath, TextureImage & image);
+bool readDDS(const char * imagepath, TextureImage & image);
+// Picks the reader from the file's magic bytes
+bool readTextureImage(const char * imagepath, TextureImage & image);
+
+// Specifies every level of the bound GL_TEXTURE_2D and sets its filtering.
+// pixels is image.data.data(), or an offset into the bound GL_PIXEL_UNPACK_BUFFER.
+void uploadTextureImage(const TextureImage & image, const void * pixels);
+
 // Load a .BMP file using our custom loader
 GLuint loadBMP_custom(const char * imagepath);
 
@@ -13,4 +36,4 @@ GLuint loadBMP_custom(const char * imagepath);
 GLuint loadDDS(const char * imagepath);
 
 
-#endif
\ No newline at end of file
+#endif
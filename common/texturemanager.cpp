@@ -0,0 +1,149 @@
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+#include <GL/glew.h>
+
+#include "texturemanager.hpp"
+
+TextureManager::TextureManager(ThreadPool & pool)
+	: pool(pool), inbox(std::make_shared<Inbox>()), pending(0), nextStagingBuffer(0)
+{
+	memset(stagingBuffers, 0, sizeof(stagingBuffers));
+}
+
+TextureManager::~TextureManager(){
+	cleanup();
+}
+
+void TextureManager::initialize(){
+	glGenBuffers(kStagingBufferCount, stagingBuffers);
+}
+
+void TextureManager::cleanup(){
+	for ( auto & entry : textures ){
+		glDeleteTextures(1, &entry.second);
+	}
+	textures.clear();
+	loaded.clear();
+	backlog.clear();
+	pending = 0;
+
+	// Reads still in flight drop their results into an inbox nobody drains
+	inbox = std::make_shared<Inbox>();
+
+	if ( stagingBuffers[0] ){
+		glDeleteBuffers(kStagingBufferCount, stagingBuffers);
+		memset(stagingBuffers, 0, sizeof(stagingBuffers));
+	}
+}
+
+GLuint TextureManager::request(const char * imagepath){
+	auto existing = textures.find(imagepath);
+	if ( existing != textures.end() ){
+		return existing->second;
+	}
+
+	GLuint textureID;
+	glGenTextures(1, &textureID);
+	applyPlaceholder(textureID);
+	textures[imagepath] = textureID;
+	loaded[textureID] = false;
+	pending++;
+
+	std::shared_ptr<Inbox> target = inbox;
+	std::string path = imagepath;
+	pool.submit([target, path, textureID](){
+		Decoded decoded;
+		decoded.textureID = textureID;
+		decoded.ok = readTextureImage(path.c_str(), decoded.image);
+
+		std::lock_guard<std::mutex> lock(target->mutex);
+		target->ready.push_back(std::move(decoded));
+	});
+	return textureID;
+}
+
+size_t TextureManager::processUploads(double budgetSeconds){
+	{
+		std::lock_guard<std::mutex> lock(inbox->mutex);
+		for ( Decoded & decoded : inbox->ready ){
+			backlog.push_back(std::move(decoded));
+		}
+		inbox->ready.clear();
+	}
+
+	typedef std::chrono::steady_clock Clock;
+	Clock::time_point start = Clock::now();
+
+	size_t uploaded = 0;
+	while ( uploaded < backlog.size() ){
+		if ( uploaded > 0 && std::chrono::duration<double>(Clock::now() - start).count() >= budgetSeconds ){
+			break;
+		}
+		upload(backlog[uploaded]);
+		uploaded++;
+	}
+	backlog.erase(backlog.begin(), backlog.begin() + uploaded);
+	pending -= uploaded;
+	return uploaded;
+}
+
+bool TextureManager::isLoaded(GLuint textureID) const {
+	auto it = loaded.find(textureID);
+	return it != loaded.end() && it->second;
+}
+
+// 2x2 magenta/black checkerboard, sharp at any scale
+void TextureManager::applyPlaceholder(GLuint textureID){
+	static const unsigned char checker[2 * 2 * 3] = {
+		255, 0, 255,   0, 0, 0,
+		0, 0, 0,       255, 0, 255,
+	};
+
+	glBindTexture(GL_TEXTURE_2D, textureID);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB, 2, 2, 0, GL_RGB, GL_UNSIGNED_BYTE, checker);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+}
+
+void TextureManager::upload(Decoded & decoded){
+	if ( !decoded.ok ){
+		return; // readTextureImage said why; the placeholder stays
+	}
+
+	// Orphan the next staging buffer so this copy never waits on the upload that last used it
+	GLuint staging = stagingBuffers[nextStagingBuffer];
+	nextStagingBuffer = (nextStagingBuffer + 1) % kStagingBufferCount;
+
+	const TextureImage & image = decoded.image;
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, staging);
+	glBufferData(GL_PIXEL_UNPACK_BUFFER, image.data.size(), nullptr, GL_STREAM_DRAW);
+	void * mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, image.data.size(),
+	                                 GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+
+	// The placeholder capped the levels at 0; give generated or stored mip chains room again
+	glBindTexture(GL_TEXTURE_2D, decoded.textureID);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 1000);
+
+	if ( mapped ){
+		memcpy(mapped, image.data.data(), image.data.size());
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+		// The driver pulls the pixels from the buffer on its own schedule
+		uploadTextureImage(image, (const void*)0);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}else{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		uploadTextureImage(image, image.data.data());
+	}
+
+	loaded[decoded.textureID] = true;
+
+	// The pixels are in GL's hands now
+	std::vector<unsigned char>().swap(decoded.image.data);
+}
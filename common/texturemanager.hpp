@@ -0,0 +1,68 @@
+#ifndef TEXTUREMANAGER_HPP
+#define TEXTUREMANAGER_HPP
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "texture.hpp"
+#include "threadpool.hpp"
+
+// Streams BMP/DDS textures in without stalling the render thread.
+//
+// request() returns a texture name at once, showing a placeholder checkerboard.
+// Files are read and validated on the thread pool; processUploads(), called once
+// per frame, then copies finished images into pixel buffer objects and
+// re-specifies the same texture from them, within a time budget. Callers keep
+// the name they were given and pick up the real image as soon as it lands.
+//
+// Everything but the file reading runs on the thread that owns the GL context.
+class TextureManager {
+public:
+	explicit TextureManager(ThreadPool & pool = ThreadPool::shared());
+	~TextureManager();
+
+	void initialize();
+	void cleanup(); // Deletes every texture handed out
+
+	// The same path always returns the same texture
+	GLuint request(const char * imagepath);
+
+	// Uploads finished images until budgetSeconds have passed; at least one per call
+	// so a long backlog always makes progress. Returns how many were uploaded.
+	size_t processUploads(double budgetSeconds);
+
+	bool isLoaded(GLuint textureID) const;
+	size_t pendingCount() const { return pending; }
+
+private:
+	struct Decoded {
+		GLuint       textureID;
+		bool         ok;
+		TextureImage image;
+	};
+
+	// Shared with in-flight reads, so they can finish safely after the manager is gone
+	struct Inbox {
+		std::mutex mutex;
+		std::vector<Decoded> ready;
+	};
+
+	void applyPlaceholder(GLuint textureID);
+	void upload(Decoded & decoded);
+
+	ThreadPool & pool;
+	std::shared_ptr<Inbox> inbox;
+	std::map<std::string, GLuint> textures;
+	std::map<GLuint, bool> loaded;
+	std::vector<Decoded> backlog; // Read, waiting for upload budget
+	size_t pending;
+
+	static const int kStagingBufferCount = 4;
+	GLuint stagingBuffers[kStagingBufferCount];
+	int nextStagingBuffer;
+};
+
+#endif
@@ -0,0 +1,55 @@
+#include <algorithm>
+
+#include "threadpool.hpp"
+
+ThreadPool::ThreadPool(unsigned int threadCount)
+	: stopping(false)
+{
+	if ( threadCount == 0 ){
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+	workers.reserve(threadCount);
+	for ( unsigned int i=0; i<threadCount; i++ ){
+		workers.emplace_back(&ThreadPool::workerLoop, this);
+	}
+}
+
+ThreadPool::~ThreadPool(){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for ( std::thread & worker : workers ){
+		worker.join();
+	}
+}
+
+ThreadPool & ThreadPool::shared(){
+	static ThreadPool pool;
+	return pool;
+}
+
+void ThreadPool::enqueue(std::function<void()> job){
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		jobs.push_back(std::move(job));
+	}
+	wake.notify_one();
+}
+
+void ThreadPool::workerLoop(){
+	for (;;){
+		std::function<void()> job;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [this](){ return stopping || !jobs.empty(); });
+			if ( jobs.empty() ){
+				return; // Stopping and drained
+			}
+			job = std::move(jobs.front());
+			jobs.pop_front();
+		}
+		job();
+	}
+}
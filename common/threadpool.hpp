@@ -0,0 +1,68 @@
+#ifndef THREADPOOL_HPP
+#define THREADPOOL_HPP
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed set of worker threads pulling jobs from one FIFO queue.
+// Jobs must not block on other jobs of the same pool.
+class ThreadPool {
+public:
+	// 0 picks one thread per hardware thread
+	explicit ThreadPool(unsigned int threadCount = 0);
+	~ThreadPool(); // Finishes every queued job before joining
+
+	ThreadPool(const ThreadPool &) = delete;
+	ThreadPool & operator=(const ThreadPool &) = delete;
+
+	template <typename F>
+	auto submit(F && job) -> std::future<decltype(job())> {
+		typedef decltype(job()) Result;
+		auto task = std::make_shared< std::packaged_task<Result()> >(std::forward<F>(job));
+		std::future<Result> result = task->get_future();
+		enqueue([task](){ (*task)(); });
+		return result;
+	}
+
+	unsigned int size() const { return (unsigned int)workers.size(); }
+
+	// Calls body(begin, end) over [0, count) in batches of at least minBatch items,
+	// one batch on the calling thread, and returns once all have run
+	template <typename F>
+	void parallelFor(size_t count, size_t minBatch, F && body){
+		size_t batches = std::max<size_t>(1, std::min<size_t>(size() * 4, count / std::max<size_t>(minBatch, 1)));
+		size_t step = (count + batches - 1) / batches;
+
+		std::vector< std::future<void> > pending;
+		for ( size_t begin = step; begin < count; begin += step ){
+			size_t end = std::min(count, begin + step);
+			pending.push_back(submit([&body, begin, end](){ body(begin, end); }));
+		}
+		body(0, std::min(count, step));
+		for ( std::future<void> & job : pending ){
+			job.get();
+		}
+	}
+
+	// Process-wide pool for loaders that want to go wide without owning threads
+	static ThreadPool & shared();
+
+private:
+	void enqueue(std::function<void()> job);
+	void workerLoop();
+
+	std::vector<std::thread> workers;
+	std::deque< std::function<void()> > jobs;
+	std::mutex mutex;
+	std::condition_variable wake;
+	bool stopping;
+};
+
+#endif
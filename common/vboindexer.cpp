@@ -1,11 +1,13 @@
 #include <vector>
-#include <map>
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
 
 #include <glm/glm.hpp>
 
 #include "vboindexer.hpp"
 
-#include <string.h> // for memcmp
+#include <string.h> // for memcpy, memcmp
 
 
 // Returns true iif v1 can be considered equal to v2
@@ -13,91 +15,235 @@ bool is_near(float v1, float v2){
 	return fabs( v1-v2 ) < 0.01f;
 }
 
-// Searches through all already-exported vertices
-// for a similar one.
-// Similar = same position + same UVs + same normal
-bool getSimilarVertexIndex( 
-	glm::vec3 & in_vertex, 
-	glm::vec2 & in_uv, 
-	glm::vec3 & in_normal, 
-	std::vector<glm::vec3> & out_vertices,
-	std::vector<glm::vec2> & out_uvs,
-	std::vector<glm::vec3> & out_normals,
-	unsigned short & result
+namespace {
+
+const unsigned int kEmptySlot = 0xFFFFFFFFu;
+const float kCellScale = 50.0f; // Cells per unit: two is_near tolerances wide
+
+struct PackedVertex{
+	glm::vec3 position;
+	glm::vec2 uv;
+	glm::vec3 normal;
+};
+
+PackedVertex pack(const std::vector<glm::vec3> & vertices, const std::vector<glm::vec2> & uvs,
+                  const std::vector<glm::vec3> & normals, size_t i){
+	PackedVertex packed = {vertices[i], uvs[i], normals[i]};
+	return packed;
+}
+
+// FNV-1a over 32-bit words, finished with a murmur3 mix so linear probing sees well spread low bits
+uint32_t hashWords(const uint32_t * words, size_t count){
+	uint32_t h = 2166136261u;
+	for ( size_t i=0; i<count; i++ ){
+		h = (h ^ words[i]) * 16777619u;
+	}
+	h ^= h >> 16; h *= 0x85ebca6bu;
+	h ^= h >> 13; h *= 0xc2b2ae35u;
+	h ^= h >> 16;
+	return h;
+}
+
+// Bit pattern of every component, so only bit-identical vertices collide on purpose
+uint32_t hashExact(const PackedVertex & v){
+	uint32_t words[8];
+	memcpy(words, &v, sizeof(words));
+	return hashWords(words, 8);
+}
+
+// Grid cell of a position. Cells are twice the is_near tolerance, so any two
+// positions is_near accepts lie in the same or adjacent cells on every axis,
+// even after the float rounding of the scale.
+glm::ivec3 positionCell(const glm::vec3 & position){
+	return glm::ivec3(glm::floor(position * kCellScale));
+}
+
+uint32_t hashCell(const glm::ivec3 & cell){
+	uint32_t words[3] = {(uint32_t)cell.x, (uint32_t)cell.y, (uint32_t)cell.z};
+	return hashWords(words, 3);
+}
+
+bool nearAll(const PackedVertex & a, const PackedVertex & b){
+	const float * fa = &a.position.x;
+	const float * fb = &b.position.x;
+	for ( int i=0; i<8; i++ ){
+		if ( !is_near(fa[i], fb[i]) ){
+			return false;
+		}
+	}
+	return true;
+}
+
+// Open-addressing deduplication: remap[i] receives the output index of input
+// vertex i, and unique the input index of each output vertex in first-seen order.
+// The table is a power of two at most half full, probed linearly.
+template <typename Hash, typename Same>
+void deduplicate(
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	Hash hash, Same same,
+	std::vector<unsigned int> & remap,
+	std::vector<unsigned int> & unique
+){
+	const size_t count = vertices.size();
+	size_t capacity = 16;
+	while ( capacity < count * 2 ){
+		capacity <<= 1;
+	}
+	const size_t mask = capacity - 1;
+
+	std::vector<unsigned int> slots(capacity, kEmptySlot);
+	remap.resize(count);
+	unique.clear();
+
+	for ( size_t i=0; i<count; i++ ){
+		PackedVertex packed = pack(vertices, uvs, normals, i);
+		size_t slot = hash(packed) & mask;
+		for (;;){
+			unsigned int candidate = slots[slot];
+			if ( candidate == kEmptySlot ){ // Not seen yet: it needs to be added in the output data
+				slots[slot] = (unsigned int)unique.size();
+				remap[i] = (unsigned int)unique.size();
+				unique.push_back((unsigned int)i);
+				break;
+			}
+			if ( same(pack(vertices, uvs, normals, unique[candidate]), packed) ){ // A similar vertex is already in the VBO, use it instead !
+				remap[i] = candidate;
+				break;
+			}
+			slot = (slot + 1) & mask;
+		}
+	}
+}
+
+// Same contract as deduplicate, merging each vertex into the first output vertex
+// that is_near accepts in every component, exactly as a linear scan of the output
+// would. Output vertices are filed under their position's grid cell, several to
+// a cell, and a lookup walks the 27 cells around the vertex's own.
+void deduplicateNear(
+	const std::vector<glm::vec3> & vertices,
+	const std::vector<glm::vec2> & uvs,
+	const std::vector<glm::vec3> & normals,
+	std::vector<unsigned int> & remap,
+	std::vector<unsigned int> & unique
 ){
-	// Lame linear search
-	for ( unsigned int i=0; i<out_vertices.size(); i++ ){
-		if (
-			is_near( in_vertex.x , out_vertices[i].x ) &&
-			is_near( in_vertex.y , out_vertices[i].y ) &&
-			is_near( in_vertex.z , out_vertices[i].z ) &&
-			is_near( in_uv.x     , out_uvs     [i].x ) &&
-			is_near( in_uv.y     , out_uvs     [i].y ) &&
-			is_near( in_normal.x , out_normals [i].x ) &&
-			is_near( in_normal.y , out_normals [i].y ) &&
-			is_near( in_normal.z , out_normals [i].z )
-		){
-			result = i;
-			return true;
+	const size_t count = vertices.size();
+	size_t capacity = 16;
+	while ( capacity < count * 2 ){
+		capacity <<= 1;
+	}
+	const size_t mask = capacity - 1;
+
+	std::vector<unsigned int> slots(capacity, kEmptySlot);
+	remap.resize(count);
+	unique.clear();
+
+	for ( size_t i=0; i<count; i++ ){
+		PackedVertex packed = pack(vertices, uvs, normals, i);
+		glm::ivec3 cell = positionCell(packed.position);
+
+		// Entries from other cells that share a probe run fail nearAll or are genuine matches
+		unsigned int match = kEmptySlot;
+		for ( int dz=-1; dz<=1; dz++ ){
+			for ( int dy=-1; dy<=1; dy++ ){
+				for ( int dx=-1; dx<=1; dx++ ){
+					size_t slot = hashCell(cell + glm::ivec3(dx, dy, dz)) & mask;
+					for ( ; slots[slot] != kEmptySlot; slot = (slot + 1) & mask ){
+						unsigned int candidate = slots[slot];
+						if ( candidate < match && nearAll(pack(vertices, uvs, normals, unique[candidate]), packed) ){
+							match = candidate;
+						}
+					}
+				}
+			}
 		}
+
+		if ( match != kEmptySlot ){ // A similar vertex is already in the VBO, use it instead !
+			remap[i] = match;
+			continue;
+		}
+
+		// Not seen yet: it needs to be added in the output data
+		size_t slot = hashCell(cell) & mask;
+		while ( slots[slot] != kEmptySlot ){
+			slot = (slot + 1) & mask;
+		}
+		slots[slot] = (unsigned int)unique.size();
+		remap[i] = (unsigned int)unique.size();
+		unique.push_back((unsigned int)i);
+	}
+}
+
+bool sameExact(const PackedVertex & a, const PackedVertex & b){
+	return memcmp(&a, &b, sizeof(PackedVertex)) == 0;
+}
+
+template <typename T>
+void gather(const std::vector<T> & in, const std::vector<unsigned int> & unique, std::vector<T> & out){
+	out.resize(unique.size());
+	for ( size_t i=0; i<unique.size(); i++ ){
+		out[i] = in[unique[i]];
+	}
+}
+
+// Narrows to 16 bits when every index fits
+void fillIndexBuffer(std::vector<unsigned int> & indices, size_t vertexCount, IndexBuffer & out){
+	out.indices16.clear();
+	out.indices32.clear();
+	if ( vertexCount > 65536 ){
+		out.indices32.swap(indices);
+		return;
+	}
+	out.indices16.assign(indices.begin(), indices.end());
+}
+
+bool narrowIndices(const std::vector<unsigned int> & indices, size_t vertexCount, std::vector<unsigned short> & out){
+	out.clear();
+	if ( vertexCount > 65536 ){
+		printf("Mesh has %u unique vertices, too many for 16-bit indices\n", (unsigned int)vertexCount);
+		return false;
 	}
-	// No other vertex could be used instead.
-	// Looks like we'll have to add it to the VBO.
-	return false;
+	out.assign(indices.begin(), indices.end());
+	return true;
 }
 
-void indexVBO_slow(
+} // namespace
+
+void indexVBO(
 	std::vector<glm::vec3> & in_vertices,
 	std::vector<glm::vec2> & in_uvs,
 	std::vector<glm::vec3> & in_normals,
 
-	std::vector<unsigned short> & out_indices,
+	std::vector<unsigned int> & out_indices,
 	std::vector<glm::vec3> & out_vertices,
 	std::vector<glm::vec2> & out_uvs,
 	std::vector<glm::vec3> & out_normals
 ){
-	// For each input vertex
-	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
-
-		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex(in_vertices[i], in_uvs[i], in_normals[i],     out_vertices, out_uvs, out_normals, index);
-
-		if ( found ){ // A similar vertex is already in the VBO, use it instead !
-			out_indices.push_back( index );
-		}else{ // If not, it needs to be added in the output data.
-			out_vertices.push_back( in_vertices[i]);
-			out_uvs     .push_back( in_uvs[i]);
-			out_normals .push_back( in_normals[i]);
-			out_indices .push_back( (unsigned short)out_vertices.size() - 1 );
-		}
-	}
+	std::vector<unsigned int> unique;
+	deduplicate(in_vertices, in_uvs, in_normals, hashExact, sameExact, out_indices, unique);
+
+	gather(in_vertices, unique, out_vertices);
+	gather(in_uvs,      unique, out_uvs);
+	gather(in_normals,  unique, out_normals);
 }
 
-struct PackedVertex{
-	glm::vec3 position;
-	glm::vec2 uv;
-	glm::vec3 normal;
-	bool operator<(const PackedVertex that) const{
-		return memcmp((void*)this, (void*)&that, sizeof(PackedVertex))>0;
-	};
-};
+void indexVBO(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
 
-bool getSimilarVertexIndex_fast( 
-	PackedVertex & packed, 
-	std::map<PackedVertex,unsigned short> & VertexToOutIndex,
-	unsigned short & result
+	IndexBuffer & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals
 ){
-	std::map<PackedVertex,unsigned short>::iterator it = VertexToOutIndex.find(packed);
-	if ( it == VertexToOutIndex.end() ){
-		return false;
-	}else{
-		result = it->second;
-		return true;
-	}
+	std::vector<unsigned int> indices;
+	indexVBO(in_vertices, in_uvs, in_normals, indices, out_vertices, out_uvs, out_normals);
+	fillIndexBuffer(indices, out_vertices.size(), out_indices);
 }
 
-void indexVBO(
+bool indexVBO(
 	std::vector<glm::vec3> & in_vertices,
 	std::vector<glm::vec2> & in_uvs,
 	std::vector<glm::vec3> & in_normals,
@@ -107,36 +253,41 @@ void indexVBO(
 	std::vector<glm::vec2> & out_uvs,
 	std::vector<glm::vec3> & out_normals
 ){
-	std::map<PackedVertex,unsigned short> VertexToOutIndex;
-
-	// For each input vertex
-	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
-
-		PackedVertex packed = {in_vertices[i], in_uvs[i], in_normals[i]};
-		
-
-		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex_fast( packed, VertexToOutIndex, index);
-
-		if ( found ){ // A similar vertex is already in the VBO, use it instead !
-			out_indices.push_back( index );
-		}else{ // If not, it needs to be added in the output data.
-			out_vertices.push_back( in_vertices[i]);
-			out_uvs     .push_back( in_uvs[i]);
-			out_normals .push_back( in_normals[i]);
-			unsigned short newindex = (unsigned short)out_vertices.size() - 1;
-			out_indices .push_back( newindex );
-			VertexToOutIndex[ packed ] = newindex;
-		}
-	}
+	std::vector<unsigned int> indices;
+	indexVBO(in_vertices, in_uvs, in_normals, indices, out_vertices, out_uvs, out_normals);
+	return narrowIndices(indices, out_vertices.size(), out_indices);
 }
 
 
+void indexVBO_TBN(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
 
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents
+){
+	std::vector<unsigned int> unique;
+	deduplicateNear(in_vertices, in_uvs, in_normals, out_indices, unique);
 
+	gather(in_vertices, unique, out_vertices);
+	gather(in_uvs,      unique, out_uvs);
+	gather(in_normals,  unique, out_normals);
 
-
+	// Average the tangents and the bitangents
+	out_tangents.assign(unique.size(), glm::vec3(0.0f));
+	out_bitangents.assign(unique.size(), glm::vec3(0.0f));
+	for ( size_t i=0; i<in_vertices.size(); i++ ){
+		out_tangents  [out_indices[i]] += in_tangents[i];
+		out_bitangents[out_indices[i]] += in_bitangents[i];
+	}
+}
 
 void indexVBO_TBN(
 	std::vector<glm::vec3> & in_vertices,
@@ -145,6 +296,26 @@ void indexVBO_TBN(
 	std::vector<glm::vec3> & in_tangents,
 	std::vector<glm::vec3> & in_bitangents,
 
+	IndexBuffer & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents
+){
+	std::vector<unsigned int> indices;
+	indexVBO_TBN(in_vertices, in_uvs, in_normals, in_tangents, in_bitangents,
+	             indices, out_vertices, out_uvs, out_normals, out_tangents, out_bitangents);
+	fillIndexBuffer(indices, out_vertices.size(), out_indices);
+}
+
+bool indexVBO_TBN(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
+
 	std::vector<unsigned short> & out_indices,
 	std::vector<glm::vec3> & out_vertices,
 	std::vector<glm::vec2> & out_uvs,
@@ -152,26 +323,8 @@ void indexVBO_TBN(
 	std::vector<glm::vec3> & out_tangents,
 	std::vector<glm::vec3> & out_bitangents
 ){
-	// For each input vertex
-	for ( unsigned int i=0; i<in_vertices.size(); i++ ){
-
-		// Try to find a similar vertex in out_XXXX
-		unsigned short index;
-		bool found = getSimilarVertexIndex(in_vertices[i], in_uvs[i], in_normals[i],     out_vertices, out_uvs, out_normals, index);
-
-		if ( found ){ // A similar vertex is already in the VBO, use it instead !
-			out_indices.push_back( index );
-
-			// Average the tangents and the bitangents
-			out_tangents[index] += in_tangents[i];
-			out_bitangents[index] += in_bitangents[i];
-		}else{ // If not, it needs to be added in the output data.
-			out_vertices.push_back( in_vertices[i]);
-			out_uvs     .push_back( in_uvs[i]);
-			out_normals .push_back( in_normals[i]);
-			out_tangents .push_back( in_tangents[i]);
-			out_bitangents .push_back( in_bitangents[i]);
-			out_indices .push_back( (unsigned short)out_vertices.size() - 1 );
-		}
-	}
+	std::vector<unsigned int> indices;
+	indexVBO_TBN(in_vertices, in_uvs, in_normals, in_tangents, in_bitangents,
+	             indices, out_vertices, out_uvs, out_normals, out_tangents, out_bitangents);
+	return narrowIndices(indices, out_vertices.size(), out_indices);
 }
@@ -1,11 +1,53 @@
 #ifndef VBOINDEXER_HPP
 #define VBOINDEXER_HPP
 
+#include <vector>
+#include <cstddef>
+#include <glm/glm.hpp>
+
+// Index data in the narrowest type that holds every index: 16 bits while the
+// mesh has at most 65536 unique vertices, 32 bits beyond that.
+struct IndexBuffer {
+	std::vector<unsigned short> indices16;
+	std::vector<unsigned int>   indices32;
+
+	bool        is32Bit() const     { return !indices32.empty(); }
+	size_t      size() const        { return is32Bit() ? indices32.size() : indices16.size(); }
+	size_t      elementSize() const { return is32Bit() ? sizeof(unsigned int) : sizeof(unsigned short); }
+	const void* data() const        { return is32Bit() ? (const void*)indices32.data() : (const void*)indices16.data(); }
+	// GL_UNSIGNED_INT or GL_UNSIGNED_SHORT, without pulling GL into this header
+	unsigned int glType() const     { return is32Bit() ? 0x1405 : 0x1403; }
+};
+
+// Merges bit-identical vertices
+void indexVBO(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals
+);
+
 void indexVBO(
 	std::vector<glm::vec3> & in_vertices,
 	std::vector<glm::vec2> & in_uvs,
 	std::vector<glm::vec3> & in_normals,
 
+	IndexBuffer & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals
+);
+
+// Returns false, leaving out_indices empty, if the mesh has more than 65536 unique vertices
+bool indexVBO(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+
 	std::vector<unsigned short> & out_indices,
 	std::vector<glm::vec3> & out_vertices,
 	std::vector<glm::vec2> & out_uvs,
@@ -13,6 +55,8 @@ void indexVBO(
 );
 
 
+// Merges vertices whose position, UV and normal agree within 0.01 per component,
+// summing the tangents and bitangents of everything merged
 void indexVBO_TBN(
 	std::vector<glm::vec3> & in_vertices,
 	std::vector<glm::vec2> & in_uvs,
@@ -20,6 +64,37 @@ void indexVBO_TBN(
 	std::vector<glm::vec3> & in_tangents,
 	std::vector<glm::vec3> & in_bitangents,
 
+	std::vector<unsigned int> & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents
+);
+
+void indexVBO_TBN(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
+
+	IndexBuffer & out_indices,
+	std::vector<glm::vec3> & out_vertices,
+	std::vector<glm::vec2> & out_uvs,
+	std::vector<glm::vec3> & out_normals,
+	std::vector<glm::vec3> & out_tangents,
+	std::vector<glm::vec3> & out_bitangents
+);
+
+// Returns false, leaving out_indices empty, if the mesh has more than 65536 unique vertices
+bool indexVBO_TBN(
+	std::vector<glm::vec3> & in_vertices,
+	std::vector<glm::vec2> & in_uvs,
+	std::vector<glm::vec3> & in_normals,
+	std::vector<glm::vec3> & in_tangents,
+	std::vector<glm::vec3> & in_bitangents,
+
 	std::vector<unsigned short> & out_indices,
 	std::vector<glm::vec3> & out_vertices,
 	std::vector<glm::vec2> & out_uvs,
@@ -28,4 +103,4 @@ void indexVBO_TBN(
 	std::vector<glm::vec3> & out_bitangents
 );
 
-#endif
\ No newline at end of file
+#endif
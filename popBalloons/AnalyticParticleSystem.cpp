@@ -0,0 +1,117 @@
+#include "AnalyticParticleSystem.h"
+#include <algorithm>
+#include <cstddef>
+
+AnalyticParticleSystem::AnalyticParticleSystem()
+    : buffer(0),
+      vao(0),
+      capacity(0),
+      head(0),
+      activeSlots(0),
+      latestDeath(0.0),
+      epoch(0.0)
+{
+}
+
+AnalyticParticleSystem::~AnalyticParticleSystem() {
+    cleanup();
+}
+
+void AnalyticParticleSystem::initialize(GLsizei particleCapacity) {
+    capacity = particleCapacity;
+
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(AnalyticParticle), nullptr, GL_DYNAMIC_DRAW);
+
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(AnalyticParticle), (void*)offsetof(AnalyticParticle, position));
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(AnalyticParticle), (void*)offsetof(AnalyticParticle, color));
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(AnalyticParticle), (void*)offsetof(AnalyticParticle, size));
+    glEnableVertexAttribArray(3);
+    glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(AnalyticParticle), (void*)offsetof(AnalyticParticle, deathTime));
+    glEnableVertexAttribArray(4);
+    glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(AnalyticParticle), (void*)offsetof(AnalyticParticle, velocity));
+    glEnableVertexAttribArray(5);
+    glVertexAttribPointer(5, 1, GL_FLOAT, GL_FALSE, sizeof(AnalyticParticle), (void*)offsetof(AnalyticParticle, spawnTime));
+
+    glBindVertexArray(0);
+
+    pending.reserve(1024);
+    staged.reserve(1024);
+    head = 0;
+    activeSlots = 0;
+    latestDeath = 0.0;
+    epoch = 0.0;
+}
+
+void AnalyticParticleSystem::cleanup() {
+    if (vao) {
+        glDeleteVertexArrays(1, &vao);
+        vao = 0;
+    }
+    if (buffer) {
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+    pending.clear();
+    staged.clear();
+}
+
+void AnalyticParticleSystem::emit(const AnalyticParticle& particle, double spawnTime, float lifetime) {
+    Pending queued = { particle, spawnTime, lifetime };
+    pending.push_back(queued);
+}
+
+void AnalyticParticleSystem::flush() {
+    if (pending.empty() || !isInitialized()) {
+        return;
+    }
+
+    // Everything drawn so far is dead: start again from slot 0 so the draw stays short,
+    // and count time from now on so the stored floats stay small
+    if (activeSlots == 0 || pending.front().spawnTime >= latestDeath) {
+        activeSlots = 0;
+        head = 0;
+        epoch = pending.front().spawnTime;
+    }
+
+    // A burst larger than the ring only keeps its newest particles
+    size_t first = pending.size() > static_cast<size_t>(capacity) ? pending.size() - capacity : 0;
+    staged.clear();
+    for (size_t i = first; i < pending.size(); ++i) {
+        AnalyticParticle particle = pending[i].particle;
+        particle.spawnTime = static_cast<float>(pending[i].spawnTime - epoch);
+        particle.deathTime = particle.spawnTime + pending[i].lifetime;
+        staged.push_back(particle);
+        latestDeath = std::max(latestDeath, pending[i].spawnTime + pending[i].lifetime);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    write(staged.data(), static_cast<GLsizei>(staged.size()));
+    pending.clear();
+}
+
+// Writes count particles at head, wrapping once if needed
+void AnalyticParticleSystem::write(const AnalyticParticle* particles, GLsizei count) {
+    GLsizei untilEnd = std::min(count, capacity - head);
+    glBufferSubData(GL_ARRAY_BUFFER, head * sizeof(AnalyticParticle), untilEnd * sizeof(AnalyticParticle), particles);
+    if (untilEnd < count) {
+        glBufferSubData(GL_ARRAY_BUFFER, 0, (count - untilEnd) * sizeof(AnalyticParticle), particles + untilEnd);
+    }
+
+    activeSlots = head + count >= capacity ? capacity : std::max(activeSlots, head + count);
+    head = (head + count) % capacity;
+}
+
+void AnalyticParticleSystem::draw(double time) const {
+    if (activeSlots == 0 || time >= latestDeath) {
+        return;
+    }
+    glBindVertexArray(vao);
+    glDrawArrays(GL_POINTS, 0, activeSlots);
+    glBindVertexArray(0);
+}
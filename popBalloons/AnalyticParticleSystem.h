@@ -0,0 +1,74 @@
+#ifndef ANALYTIC_PARTICLE_SYSTEM_H
+#define ANALYTIC_PARTICLE_SYSTEM_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+
+// A fragment's whole motion, written once when it is emitted
+struct AnalyticParticle {
+    glm::vec3 position; // At spawnTime
+    glm::vec3 velocity; // At spawnTime
+    glm::vec4 color;
+    float size;
+    float spawnTime;    // Seconds after the system's epoch, as FrameData.time counts them
+    float deathTime;    // spawnTime + lifetime; SimpleVertexShader's vertexLifetime
+};
+
+// Fragments that are never simulated: SimpleVertexShader built with ANALYTIC
+// evaluates each one's position under gravity and its fade in closed form from
+// the FrameData time, so a frame costs one uniform update however many are alive.
+//
+// Particles are written once into a ring of slots in a single buffer; the
+// oldest slots are recycled first, which with a shared lifetime are also the
+// first to have expired. Slots that have not expired yet are only overwritten
+// when more particles are alive than the ring holds.
+//
+// The shader's times are floats, whose step reaches about 2 ms after 8 hours
+// and would show in the fade. So stored times count from an epoch that moves
+// up to the first new spawn whenever the ring restarts, which happens each time
+// every fragment has expired. Precision only degrades while fragments are kept
+// alive without a break: the step is about 1 ms after 4 hours of that.
+class AnalyticParticleSystem {
+public:
+    static const GLsizei kDefaultCapacity = 1 << 16;
+
+    AnalyticParticleSystem();
+    ~AnalyticParticleSystem();
+
+    void initialize(GLsizei capacity = kDefaultCapacity);
+    void cleanup();
+    bool isInitialized() const { return buffer != 0; }
+
+    // Queued until the next flush(); the particle's own spawn and death times are filled in then
+    void emit(const AnalyticParticle& particle, double spawnTime, float lifetime);
+    // Writes the queued particles into the ring, moving the epoch up if the ring restarts
+    void flush();
+    // Draws every slot that can still be alive at time; attributes 0-5 match SimpleVertexShader's
+    void draw(double time) const;
+
+    // Time the stored spawn and death times count from; FrameData.time must count from it too
+    double getEpoch() const { return epoch; }
+
+private:
+    struct Pending {
+        AnalyticParticle particle;
+        double spawnTime;
+        float lifetime;
+    };
+
+    void write(const AnalyticParticle* particles, GLsizei count);
+
+    GLuint buffer;
+    GLuint vao;
+    GLsizei capacity;
+    GLsizei head;         // Next slot to overwrite
+    GLsizei activeSlots;  // Slots [0, activeSlots) have been written at least once
+    double latestDeath;   // Nothing is alive after this time
+    double epoch;
+
+    std::vector<Pending> pending;
+    std::vector<AnalyticParticle> staged; // pending with times relative to epoch, as uploaded
+};
+
+#endif // ANALYTIC_PARTICLE_SYSTEM_H
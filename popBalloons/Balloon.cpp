@@ -1,5 +1,5 @@
 #include "Balloon.h"
-#include <iostream>
+#include "Log.h"
 
 
 Balloon::Balloon(const glm::vec3& position, float size, const glm::vec3& color)
@@ -8,9 +8,8 @@ Balloon::Balloon(const glm::vec3& position, float size, const glm::vec3& color)
 }
 
 void Balloon::update(float deltaTime) {
-    std::cout << "Updating balloon with deltaTime: " << deltaTime <<
-                 ", speed: " << speed <<
-                 ", velocity: (" << velocity.x << ", " << velocity.y << ")" << std::endl;
+    LOG_TRACE("Updating balloon with deltaTime: %f, speed: %f, velocity: (%f, %f)",
+              deltaTime, speed, velocity.x, velocity.y);
                  
     position += velocity * deltaTime * speed; // Update the position using velocity and speed
 
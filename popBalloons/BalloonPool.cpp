@@ -0,0 +1,164 @@
+#include "BalloonPool.h"
+#include <algorithm>
+
+// The grid spans the spawn range plus a balloon radius of slack; cells are sized
+// to the default hitbox so a click only has to look at the 3x3 cells around it
+BalloonPool::BalloonPool()
+    : nextSpawn(0),
+      maxSize(0.0f),
+      grid(-1.5f, -1.5f, 1.5f, 1.5f, 0.3f)
+{
+}
+
+void BalloonPool::reserve(size_t capacity) {
+    x.reserve(capacity);
+    y.reserve(capacity);
+    previousX.reserve(capacity);
+    previousY.reserve(capacity);
+    vx.reserve(capacity);
+    vy.reserve(capacity);
+    speed.reserve(capacity);
+    sizes.reserve(capacity);
+    color.reserve(capacity);
+    spawnOrder.reserve(capacity);
+}
+
+void BalloonPool::clear() {
+    x.clear();
+    y.clear();
+    previousX.clear();
+    previousY.clear();
+    vx.clear();
+    vy.clear();
+    speed.clear();
+    sizes.clear();
+    color.clear();
+    spawnOrder.clear();
+    nextSpawn = 0;
+    maxSize = 0.0f;
+    grid.clear();
+}
+
+size_t BalloonPool::add(const Balloon& balloon) {
+    glm::vec3 position = balloon.getPosition();
+    glm::vec3 velocity = balloon.getVelocity();
+
+    x.push_back(position.x);
+    y.push_back(position.y);
+    previousX.push_back(position.x);
+    previousY.push_back(position.y);
+    vx.push_back(velocity.x);
+    vy.push_back(velocity.y);
+    speed.push_back(balloon.getSpeed());
+    sizes.push_back(balloon.getSize());
+    color.push_back(balloon.getColor());
+    spawnOrder.push_back(nextSpawn++);
+
+    size_t index = x.size() - 1;
+    maxSize = std::max(maxSize, balloon.getSize());
+    grid.insert(static_cast<uint32_t>(index), position.x, position.y);
+    return index;
+}
+
+void BalloonPool::remove(size_t index) {
+    grid.removeSwap(static_cast<uint32_t>(index));
+
+    // Move the last balloon into the freed slot, then drop the tail
+    size_t last = x.size() - 1;
+    if (index != last) {
+        x[index] = x[last];
+        y[index] = y[last];
+        previousX[index] = previousX[last];
+        previousY[index] = previousY[last];
+        vx[index] = vx[last];
+        vy[index] = vy[last];
+        speed[index] = speed[last];
+        sizes[index] = sizes[last];
+        color[index] = color[last];
+        spawnOrder[index] = spawnOrder[last];
+    }
+
+    x.pop_back();
+    y.pop_back();
+    previousX.pop_back();
+    previousY.pop_back();
+    vx.pop_back();
+    vy.pop_back();
+    speed.pop_back();
+    sizes.pop_back();
+    color.pop_back();
+    spawnOrder.pop_back();
+}
+
+void BalloonPool::update(float deltaTime) {
+    // Same integration as Balloon::update, one field array at a time
+    const size_t count = x.size();
+    previousX.assign(x.begin(), x.end());
+    previousY.assign(y.begin(), y.end());
+    for (size_t i = 0; i < count; ++i) {
+        x[i] += vx[i] * deltaTime * speed[i];
+        y[i] += vy[i] * deltaTime * speed[i];
+    }
+
+    // Balloons rise slowly relative to the cell size, so most of these are a compare and return
+    for (size_t i = 0; i < count; ++i) {
+        grid.move(static_cast<uint32_t>(i), x[i], y[i]);
+    }
+}
+
+size_t BalloonPool::removeOffScreen() {
+    const float screenTop = 1.0f;
+    size_t removed = 0;
+
+    for (size_t i = 0; i < x.size();) {
+        if (y[i] > screenTop) {
+            remove(i); // The swapped-in balloon is checked on the next pass
+            ++removed;
+        } else {
+            ++i;
+        }
+    }
+
+    return removed;
+}
+
+void BalloonPool::setSpeed(float newSpeed) {
+    for (float& s : speed) {
+        s = newSpeed;
+    }
+}
+
+bool BalloonPool::findHit(float worldX, float worldY, float hitboxScale, HitPick pick, size_t& hit) const {
+    bool found = false;
+    float bestDistanceSquared = 0.0f;
+
+    grid.forEachNear(worldX, worldY, maxSize * hitboxScale, [&](uint32_t i) {
+        float hitboxRadius = sizes[i] * hitboxScale;
+        float dx = worldX - x[i];
+        float dy = worldY - y[i];
+        float distanceSquared = dx * dx + dy * dy;
+        if (distanceSquared > hitboxRadius * hitboxRadius) {
+            return;
+        }
+
+        // Grid cells are visited in arbitrary order, so break every tie on the spawn order;
+        // the index would not do, since swap-and-pop reorders it
+        bool better;
+        if (!found) {
+            better = true;
+        } else if (pick == HitPick::Topmost) {
+            better = spawnOrder[i] < spawnOrder[hit];
+        } else {
+            better = distanceSquared < bestDistanceSquared ||
+                     (distanceSquared == bestDistanceSquared && spawnOrder[i] < spawnOrder[hit]);
+        }
+
+        if (better) {
+            found = true;
+            hit = i;
+            bestDistanceSquared = distanceSquared;
+        }
+    });
+
+    return found;
+}
@@ -0,0 +1,72 @@
+#ifndef BALLOON_POOL_H
+#define BALLOON_POOL_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "Balloon.h"
+#include "SpatialGrid.h"
+
+// Which balloon a click picks when several hitboxes overlap the cursor
+enum class HitPick {
+    Topmost, // The one drawn on top: the earliest spawned, which Renderer::balloonDepth places nearest
+    Nearest  // The one whose centre is closest to the cursor, earliest spawned on ties
+};
+
+// Structure-of-arrays storage for every live balloon.
+// Each field lives in its own contiguous array so integration, culling and
+// hit testing only stream through the fields they actually read.
+// Removal swaps the last balloon into the freed slot, so indices are not stable;
+// each balloon's spawn sequence number moves with it and orders them for drawing.
+// Positions from before the last update() are kept alongside the current ones
+// so the renderer can interpolate between fixed simulation steps.
+// A uniform grid over the play area is kept in step with every add, move and
+// removal so hit tests only look at balloons near the cursor.
+class BalloonPool {
+public:
+    BalloonPool();
+
+    void reserve(size_t capacity);
+    void clear();
+
+    size_t add(const Balloon& balloon);
+    void remove(size_t index); // Swap-and-pop
+
+    void update(float deltaTime);
+    size_t removeOffScreen(); // Returns how many balloons left the screen
+    void setSpeed(float newSpeed);
+
+    // Finds the balloon whose hitbox (radius * hitboxScale) contains the world-space point
+    bool findHit(float worldX, float worldY, float hitboxScale, HitPick pick, size_t& hit) const;
+
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+    glm::vec3 getPosition(size_t index) const { return glm::vec3(x[index], y[index], 0.0f); }
+
+    const std::vector<float>& getX() const { return x; }
+    const std::vector<float>& getY() const { return y; }
+    const std::vector<float>& getPreviousX() const { return previousX; }
+    const std::vector<float>& getPreviousY() const { return previousY; }
+    const std::vector<float>& getSize() const { return sizes; }
+    const std::vector<glm::vec3>& getColor() const { return color; }
+    const std::vector<uint32_t>& getSpawnOrder() const { return spawnOrder; }
+
+private:
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> previousX; // Position before the last update; equal to x, y for balloons added since
+    std::vector<float> previousY;
+    std::vector<float> vx;
+    std::vector<float> vy;
+    std::vector<float> speed;
+    std::vector<float> sizes;
+    std::vector<glm::vec3> color;
+    std::vector<uint32_t> spawnOrder; // Sequence number from add(); lower is drawn on top
+
+    uint32_t nextSpawn; // Handed to the next add(); restarts at 0 on clear()
+    float maxSize; // Largest radius ever added; bounds how far a hit test has to look
+    SpatialGrid grid;
+};
+
+#endif // BALLOON_POOL_H
@@ -0,0 +1,101 @@
+#ifndef CIRCLE_LOD_H
+#define CIRCLE_LOD_H
+
+#include <array>
+#include <cstddef>
+
+// Unit-circle triangle fans at several levels of detail, computed by the
+// compiler so no trigonometry runs at startup or in the frame loop.
+//
+// Each level is a fan of kSegments[level] + 2 vertices: the centre, then the
+// rim from angle 0 round to 2*pi again. All levels sit back to back in kFans,
+// so one vertex buffer holds them and a draw picks a level by its first vertex.
+namespace CircleLod {
+
+struct Vertex {
+    float x;
+    float y;
+};
+
+constexpr unsigned int kSegments[] = { 8, 12, 16, 24, 32, 48, 64, 96, 128 };
+constexpr size_t kLevelCount = sizeof(kSegments) / sizeof(kSegments[0]);
+
+// Largest gap, in pixels, allowed between a fan's edge and the true circle
+constexpr float kMaxErrorPixels = 0.5f;
+
+constexpr double kPi = 3.14159265358979323846;
+
+// Taylor series after reducing to [-pi, pi], where 30 terms are well past double precision
+constexpr double sine(double x) {
+    while (x > kPi) {
+        x -= 2.0 * kPi;
+    }
+    while (x < -kPi) {
+        x += 2.0 * kPi;
+    }
+    double term = x;
+    double sum = x;
+    for (int i = 1; i < 30; ++i) {
+        term *= -x * x / ((2.0 * i) * (2.0 * i + 1.0));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr double cosine(double x) {
+    return sine(x + 0.5 * kPi);
+}
+
+constexpr size_t vertexCount(size_t level) {
+    return kSegments[level] + 2;
+}
+
+constexpr size_t firstVertex(size_t level) {
+    size_t first = 0;
+    for (size_t i = 0; i < level; ++i) {
+        first += vertexCount(i);
+    }
+    return first;
+}
+
+constexpr size_t kVertexCount = firstVertex(kLevelCount);
+
+constexpr std::array<Vertex, kVertexCount> buildFans() {
+    std::array<Vertex, kVertexCount> fans{};
+    for (size_t level = 0; level < kLevelCount; ++level) {
+        size_t first = firstVertex(level);
+        fans[first] = Vertex{ 0.0f, 0.0f }; // Fan centre
+        for (unsigned int i = 0; i <= kSegments[level]; ++i) {
+            double theta = 2.0 * kPi * i / kSegments[level];
+            fans[first + 1 + i] = Vertex{ static_cast<float>(cosine(theta)), static_cast<float>(sine(theta)) };
+        }
+    }
+    return fans;
+}
+
+// A chord of n segments falls short of the circle by r * (1 - cos(pi / n)),
+// so each level is exact enough for radii up to the one where that reaches kMaxErrorPixels
+constexpr std::array<float, kLevelCount> buildMaxPixelRadii() {
+    std::array<float, kLevelCount> radii{};
+    for (size_t level = 0; level < kLevelCount; ++level) {
+        radii[level] = static_cast<float>(kMaxErrorPixels / (1.0 - cosine(kPi / kSegments[level])));
+    }
+    return radii;
+}
+
+constexpr std::array<Vertex, kVertexCount> kFans = buildFans();
+constexpr std::array<float, kLevelCount> kMaxPixelRadius = buildMaxPixelRadii();
+
+// Coarsest level that stays within kMaxErrorPixels at this on-screen radius
+inline size_t levelFor(float pixelRadius) {
+    for (size_t level = 0; level + 1 < kLevelCount; ++level) {
+        if (pixelRadius <= kMaxPixelRadius[level]) {
+            return level;
+        }
+    }
+    return kLevelCount - 1;
+}
+
+} // namespace CircleLod
+
+#endif // CIRCLE_LOD_H
@@ -0,0 +1,27 @@
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <chrono>
+
+// Source of wall-clock time, in seconds, for whatever drives Game::update.
+// The game itself only ever sees the deltaTime it is stepped with.
+class Clock {
+public:
+    virtual ~Clock() {}
+    virtual double now() const = 0;
+};
+
+// Monotonic system clock that works without GLFW being initialized
+class SteadyClock : public Clock {
+public:
+    SteadyClock() : start(std::chrono::steady_clock::now()) {}
+
+    double now() const override {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+private:
+    std::chrono::steady_clock::time_point start;
+};
+
+#endif // CLOCK_H
@@ -0,0 +1,57 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+FrameArena::FrameArena(size_t initialCapacity)
+    : block(static_cast<unsigned char*>(::operator new(initialCapacity))),
+      capacity(initialCapacity),
+      used(0),
+      overflowBytes(0),
+      peakBytes(0),
+      overflowCount(0)
+{
+}
+
+FrameArena::~FrameArena() {
+    for (void* memory : overflowBlocks) {
+        ::operator delete(memory);
+    }
+    ::operator delete(block);
+}
+
+void* FrameArena::allocate(size_t bytes, size_t alignment) {
+    uintptr_t base = reinterpret_cast<uintptr_t>(block);
+    size_t offset = ((base + used + alignment - 1) & ~(alignment - 1)) - base;
+    if (offset + bytes <= capacity) {
+        used = offset + bytes;
+        peakBytes = std::max(peakBytes, getUsedBytes());
+        return block + offset;
+    }
+
+    // Out of room: serve it from the heap for now and remember to grow on reset
+    void* memory = ::operator new(bytes);
+    overflowBlocks.push_back(memory);
+    overflowBytes += bytes + alignment;
+    ++overflowCount;
+    peakBytes = std::max(peakBytes, getUsedBytes());
+    return memory;
+}
+
+void FrameArena::reset() {
+    for (void* memory : overflowBlocks) {
+        ::operator delete(memory);
+    }
+
+    if (!overflowBlocks.empty()) {
+        overflowBlocks.clear();
+        // Room for the whole of the worst frame so far, with headroom for slow growth
+        size_t newCapacity = peakBytes + peakBytes / 2;
+        ::operator delete(block);
+        block = static_cast<unsigned char*>(::operator new(newCapacity));
+        capacity = newCapacity;
+    }
+
+    used = 0;
+    overflowBytes = 0;
+}
@@ -0,0 +1,69 @@
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+// Linear bump allocator for data that lives for one frame (or one snapshot).
+// allocate() just advances an offset into a single block; nothing is freed
+// individually, reset() releases everything at once.
+//
+// A request that does not fit falls back to the heap and is counted as an
+// overflow; the next reset() grows the block to the peak seen, so a workload
+// that settles stops touching the heap after its first few frames.
+// Not thread-safe: each arena belongs to one thread at a time.
+class FrameArena {
+public:
+    explicit FrameArena(size_t initialCapacity = 64 * 1024);
+    ~FrameArena();
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t));
+    // Invalidates everything allocated since the last reset
+    void reset();
+
+    size_t getCapacity() const { return capacity; }
+    size_t getUsedBytes() const { return used + overflowBytes; }
+    size_t getPeakBytes() const { return peakBytes; }        // Most bytes requested between two resets
+    size_t getOverflowCount() const { return overflowCount; } // Allocations served by the heap fallback, ever
+
+private:
+    unsigned char* block;
+    size_t capacity;
+    size_t used;
+    size_t overflowBytes;            // Requested through the fallback since the last reset
+    std::vector<void*> overflowBlocks; // Freed on reset
+    size_t peakBytes;
+    size_t overflowCount;
+};
+
+// Standard allocator adapter, so STL containers can take their storage from a FrameArena.
+// deallocate() is a no-op; a container must drop its storage before the arena is reset.
+template <typename T>
+class ArenaAllocator {
+public:
+    typedef T value_type;
+
+    explicit ArenaAllocator(FrameArena& arena) : arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+
+    T* allocate(size_t count) { return static_cast<T*>(arena->allocate(count * sizeof(T), alignof(T))); }
+    void deallocate(T*, size_t) {}
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <typename U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+
+private:
+    template <typename U> friend class ArenaAllocator;
+    FrameArena* arena;
+};
+
+template <typename T>
+using ArenaVector = std::vector<T, ArenaAllocator<T>>;
+
+#endif // FRAME_ARENA_H
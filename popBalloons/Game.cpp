@@ -1,22 +1,43 @@
 #include "Game.h"
 #include "Fragment.h"
-#include <iostream>
+#include "Clock.h"
+#include "Log.h"
+#include "Profiler.h"
 #include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
 #include <glm/gtc/matrix_transform.hpp> 
-#include <glm/gtc/random.hpp>
 
 Game::Game()
-    : score(0),
+    : Game(std::random_device{}()) {
+}
+
+Game::Game(uint32_t seed)
+    : window(nullptr),
+      score(0),
       lives(3),
-      gen(std::random_device{}()),
-      window(nullptr), 
+      gameOver(false),
+      tickInterval(1.0 / 120.0),
+      maxCatchUpSteps(8),
+      simulationTime(0.0),
+      seed(seed),
+      gen(seed),
+      fbWidth(0),
+      fbHeight(0),
+      simulationRunning(false),
+      particleBackend(ParticleBackend::Cpu),
+      balloonShading(BalloonShading::Mesh),
+      tickCount(0),
       balloonSpeedMultiplier(1.0f),
       balloonSpawnInterval(1.0f), // Initial spawn interval of 1 seconds
       balloonSpawnSpeedIncrease(0.1f)
 {
-    lastTime = glfwGetTime(); // Initialize lastTime to current time
-    nextBalloonTime = lastTime + balloonSpawnInterval; // Set initial timer using lastTime
-    
+    nextBalloonTime = simulationTime + balloonSpawnInterval; // Set initial timer from the start of the simulation
+
+    // Room for a busy screen up front, so steady-state steps never regrow the pools
+    balloons.reserve(64);
+    fragments.reserve(1024);
 }
 
 Game::~Game() {
@@ -25,78 +46,223 @@ Game::~Game() {
 
 void Game::run() {
     if (!initializeGLFW() || !initializeWindow() || !initializeGLEW()) {
-        std::cerr << "Initialization failed." << std::endl;
+        LOG_ERROR("Initialization failed.");
         return;
     }
 
     setupScene();
 
+    if (particleBackend != ParticleBackend::Cpu) {
+        particleBackend = renderer.setParticleBackend(particleBackend);
+    }
+    balloonShading = renderer.setBalloonShading(balloonShading);
+
     registerClickCallback();
-    // Main game loop
+    registerKeyCallback();
+    Profiler::setThreadName("Main");
+    Profiler::initializeGpu();
+
+    if (!recordOutputPath.empty() &&
+        recorder.open(recordOutputPath.c_str(), seed, fbWidth, fbHeight)) {
+        LOG_INFO("Recording inputs to %s (seed %u)", recordOutputPath.c_str(), seed);
+    }
+
+    // Both threads read the same clock, so frames can tell how far past a snapshot they are
+    SteadyClock clock;
+    publishSnapshot(clock.now());
+    simulationRunning.store(true, std::memory_order_release);
+    simulationThread = std::thread(&Game::simulationLoop, this, std::cref(clock));
+    uint64_t drawnTick = 0;
+
+    // Main game loop: input and presentation only, so a slow simulation step never delays them
     while (!glfwWindowShouldClose(window)) {
-        double currentTime = glfwGetTime();
-        double deltaTime = currentTime - lastTime;
-        lastTime = currentTime;
+        Profiler::beginFrame();
+
+        const RenderSnapshot& snapshot = snapshots.latest();
+        if (snapshot.gameOver) {
+            glfwSetWindowShouldClose(window, GL_TRUE);
+        }
+
+        // Draw between the snapshot's last two steps, by how far the clock is into the next one
+        double alpha = std::min(std::max((clock.now() - snapshot.stateTime) / tickInterval, 0.0), 1.0);
+        renderer.setTime((static_cast<double>(snapshot.tick) - 1.0 + alpha) * tickInterval);
+
+        if (particleBackend != ParticleBackend::Cpu) {
+            PROFILE_SCOPE("gpuParticles");
+            FragmentEmit emit;
+            while (fragmentEmitQueue.pop(emit)) {
+                renderer.emitParticle(emit.particle, emit.spawnTime);
+            }
+            // Advance by the simulation time this snapshot moved on, so GPU fragments keep the game's pace
+            renderer.updateParticles(static_cast<float>((snapshot.tick - drawnTick) * tickInterval),
+                                     snapshot.tick * tickInterval);
+        }
+        drawnTick = snapshot.tick;
+
+        {
+            PROFILE_SCOPE("renderScene");
+            PROFILE_GPU_SCOPE("renderScene");
+            renderScene(snapshot, static_cast<float>(alpha));
+        }
+        {
+            PROFILE_SCOPE("swapBuffers");
+            glfwSwapBuffers(window);
+        }
+        {
+            PROFILE_SCOPE("pollEvents");
+            glfwPollEvents();
+        }
 
-        update(deltaTime);
-        renderScene();
+        Profiler::endFrame();
+    }
+
+    simulationRunning.store(false, std::memory_order_release);
+    simulationThread.join();
 
-        glfwSwapBuffers(window);
-        glfwPollEvents();
+    if (!traceOutputPath.empty()) {
+        if (Profiler::writeChromeTrace(traceOutputPath.c_str())) {
+            LOG_INFO("Wrote frame trace to %s", traceOutputPath.c_str());
+        } else {
+            LOG_ERROR("Could not write frame trace to %s", traceOutputPath.c_str());
+        }
     }
 
+    if (recorder.isOpen()) {
+        recorder.recordEnd(stateHash());
+    }
+    recorder.close();
+    Profiler::cleanupGpu();
     cleanup();
 }
 
-void Game::update(float deltaTime) {
-    // Update each balloon using deltaTime
-    for (auto& balloon : balloons) {
-        balloon.update(deltaTime);
-    }
+// Steps the game in fixed ticks against the clock and publishes a snapshot after each
+// batch. Owns every piece of game state while it runs.
+void Game::simulationLoop(const Clock& clock) {
+    double lastTime = clock.now();
+    double accumulator = 0.0;
+    const float deltaTime = static_cast<float>(tickInterval);
+    Profiler::setThreadName("Simulation");
+
+    while (simulationRunning.load(std::memory_order_acquire)) {
+        Profiler::beginFrame();
+        double currentTime = clock.now();
+        accumulator += currentTime - lastTime;
+        lastTime = currentTime;
 
+        bool changed = false;
+        InputEvent event;
+        while (inputQueue.pop(event)) {
+            applyInput(event);
+            changed = true;
+        }
 
-    // Update the fragments
-    for (auto it = fragments.begin(); it != fragments.end();) {
-        it->position += it->velocity * deltaTime;  // Update position based on velocity
-        it->velocity += glm::vec3(0.0f, -9.8f * deltaTime, 0.0f); 
+        // Once the game is over nothing is stepped; the batch that ended it publishes the final snapshot
+        int steps = 0;
+        while (!gameOver && accumulator >= tickInterval && steps < maxCatchUpSteps) {
+            PROFILE_SCOPE("update");
+            if (recorder.isOpen()) {
+                recorder.recordTick(deltaTime);
+            }
+            update(deltaTime);
+            accumulator -= tickInterval;
+            ++tickCount;
+            ++steps;
+        }
 
-        // Fade out the fragment over time or shrink it
-        it->color.a = glm::max(it->color.a - (deltaTime / it->lifetime), 0.0f);
-        // Reduce the fragment's lifetime
-        it->lifetime -= deltaTime;
+        // After a hitch, drop what the cap left over so the game slows down for
+        // a moment instead of falling further behind every frame
+        if (gameOver) {
+            accumulator = 0.0;
+        } else if (accumulator >= tickInterval) {
+            LOG_DEBUG("Dropped %.1f ms of simulation after a slow step", (accumulator - std::fmod(accumulator, tickInterval)) * 1000.0);
+            accumulator = std::fmod(accumulator, tickInterval);
+        }
 
-        
-        if (it->lifetime <= 0.0f) {
-            it = fragments.erase(it);
-        } else {
-            ++it;
+        if (changed || steps > 0) {
+            PROFILE_SCOPE("publishSnapshot");
+            publishSnapshot(currentTime - accumulator);
+        }
+        Profiler::endFrame();
+
+        // Sleep until the next tick is due
+        double wait = tickInterval - accumulator - (clock.now() - currentTime);
+        if (wait > 0.0) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+        }
+    }
+}
+
+// Applies one window event on the simulation thread, recording it first so replays see the same order
+void Game::applyInput(const InputEvent& event) {
+    switch (event.type) {
+    case InputEvent::Click:
+        if (recorder.isOpen()) {
+            recorder.recordClick(event.x, event.y);
+        }
+        handleClick(event.x, event.y);
+        break;
+    case InputEvent::Resize:
+        if (recorder.isOpen()) {
+            recorder.recordResize(event.width, event.height);
         }
+        setFramebufferSize(event.width, event.height);
+        break;
+    }
+}
+
+void Game::publishSnapshot(double stateTime) {
+    RenderSnapshot& snapshot = snapshots.writeSlot();
+    snapshot.capture(balloons, fragments);
+    snapshot.stateTime = stateTime;
+    snapshot.tick = tickCount;
+    snapshot.score = score;
+    snapshot.lives = lives;
+    snapshot.gameOver = gameOver;
+    snapshots.publish();
+}
+
+// Called from the GLFW callbacks on the main thread
+void Game::queueInput(const InputEvent& event) {
+    if (!inputQueue.push(event)) {
+        LOG_WARN("Input queue is full, dropping an event");
+    }
+}
+
+void Game::update(float deltaTime) {
+    // A finished game stays as it ended, so escapes cannot take lives below zero
+    if (gameOver) {
+        return;
     }
 
+    // Advance the simulation clock; spawning is scheduled against it rather than wall time
+    simulationTime += deltaTime;
+
+    // Update each balloon using deltaTime
+    balloons.update(deltaTime);
+
+
+    // Update the fragments: move, apply gravity, fade out and drop the expired ones
+    fragments.update(deltaTime);
+
     // Check if any balloons are off-screen and remove them
-    for (size_t i = 0; i < balloons.size();) {
-        if (balloons[i].isOffScreen()) {
-            balloons.erase(balloons.begin() + i);
-            --lives;
-            
-            // Reset balloon speed multiplier if a life is lost
-            balloonSpeedMultiplier = 1.0f;
-            
-            // Game over logic
-            if (lives <= 0) {
-                endGame();
-                return; // Stop the update loop because the game is over
-            }
-        } else {
-            ++i;
+    size_t escaped = balloons.removeOffScreen();
+    if (escaped > 0) {
+        lives -= static_cast<int>(escaped);
+
+        // Reset balloon speed multiplier if a life is lost
+        balloonSpeedMultiplier = 1.0f;
+
+        // Game over logic
+        if (lives <= 0) {
+            endGame();
+            return; // Stop the update loop because the game is over
         }
     }
 
     // Check if it's time to create a new balloon
-    float currentTime = glfwGetTime();
-    if (currentTime >= nextBalloonTime) {
+    if (simulationTime >= nextBalloonTime) {
         createBalloon(); // Create a new balloon
-        nextBalloonTime = currentTime + balloonSpawnInterval; // Set the time for creating the next balloon
+        nextBalloonTime = simulationTime + balloonSpawnInterval; // Set the time for creating the next balloon
     }
 }
 
@@ -105,15 +271,14 @@ void Game::popBalloon(int balloonIndex) {
         return; // Index out of range
     }
 
-    Balloon& balloon = balloons[balloonIndex];
+    glm::vec3 balloonPosition = balloons.getPosition(balloonIndex);
+    glm::vec3 balloonColor = balloons.getColor()[balloonIndex];
     // Increase the balloon speed multiplier
     // Increase the balloon speed multiplier by a smaller amount
     balloonSpeedMultiplier += 0.05f; 
 
     // Update the speed of all remaining balloons
-    for (auto& balloon : balloons) {
-        balloon.setSpeed(balloonSpeedMultiplier);
-    }
+    balloons.setSpeed(balloonSpeedMultiplier);
 
     // Increase the score based on the speed multiplier
     score += static_cast<int>(100 * balloonSpeedMultiplier);
@@ -121,22 +286,60 @@ void Game::popBalloon(int balloonIndex) {
     balloonSpawnInterval = std::max(balloonSpawnInterval - balloonSpawnSpeedIncrease, 0.5f); 
 
     // Immediate application of the new balloon spawn interval
-    nextBalloonTime = glfwGetTime() + balloonSpawnInterval;
+    nextBalloonTime = simulationTime + balloonSpawnInterval;
 
     // Generate the fragments for the explosion effect
     int numFragments = 10; 
     for (int i = 0; i < numFragments; ++i) {
-        glm::vec3 position = balloon.getPosition(); // Start the fragment at the balloon's position
-        glm::vec3 velocity = glm::ballRand(1.0f);   // Randomize velocity direction
-        glm::vec4 color = glm::vec4(balloon.getColor(), 1.0f); 
+        glm::vec3 position = balloonPosition; // Start the fragment at the balloon's position
+        glm::vec3 velocity = randomFragmentVelocity(); // Randomize velocity direction
+        glm::vec4 color = glm::vec4(balloonColor, 1.0f); 
         float size = 5.0f;      // Size of the fragment (use the appropriate size for your fragment)
         float lifetime = 1.0f;  // Set how long the fragment should be alive
 
+        if (particleBackend != ParticleBackend::Cpu) {
+            // Spawned at the time of the state the balloon was popped in, before the coming tick
+            FragmentEmit emit = { { position, velocity, color, size, lifetime }, tickCount * tickInterval };
+            if (!fragmentEmitQueue.push(emit)) {
+                LOG_DEBUG("Fragment emit queue is full, dropping a fragment");
+            }
+            continue;
+        }
+
         Fragment frag(position, velocity, color, size, lifetime); // Using the Fragment constructor with parameters
-        fragments.push_back(frag);
+        fragments.emit(frag);
+    }
+
+    balloons.remove(balloonIndex);
+}
+
+// Uniform point in the unit ball, drawn from gen so a seeded run is reproducible
+// (glm::ballRand uses the global std::rand state)
+glm::vec3 Game::randomFragmentVelocity() {
+    std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+    glm::vec3 v;
+    do {
+        v = glm::vec3(dis(gen), dis(gen), dis(gen));
+    } while (glm::dot(v, v) > 1.0f);
+    return v;
+}
+
+// Pops the balloon closest to escaping; used to stand in for the player when running headless
+bool Game::popHighestBalloon() {
+    if (balloons.empty()) {
+        return false;
     }
 
-    balloons.erase(balloons.begin() + balloonIndex);
+    const std::vector<float>& balloonY = balloons.getY();
+    size_t highest = 0;
+    for (size_t i = 1; i < balloonY.size(); ++i) {
+        if (balloonY[i] > balloonY[highest]) {
+            highest = i;
+        }
+    }
+
+    popBalloon(static_cast<int>(highest));
+    return true;
 }
 
 
@@ -156,7 +359,20 @@ void Game::createBalloon() {
     
     newBalloon.setVelocity(glm::vec3(0.0f, 1.0f, 0.0f)); 
 
-    balloons.push_back(newBalloon);
+    balloons.add(newBalloon);
+}
+
+// Starts a new game with the same window and random generator
+void Game::reset() {
+    balloons.clear();
+    fragments.clear();
+    score = 0;
+    lives = 3;
+    gameOver = false;
+    simulationTime = 0.0;
+    balloonSpeedMultiplier = 1.0f;
+    balloonSpawnInterval = 1.0f;
+    nextBalloonTime = simulationTime + balloonSpawnInterval;
 }
 
 void Game::cleanup() {
@@ -175,7 +391,7 @@ void Game::cleanup() {
 bool Game::initializeGLFW() {
     // Initialize GLFW
     if (!glfwInit()) {
-        std::cerr << "Failed to initialize GLFW\n";
+        LOG_ERROR("Failed to initialize GLFW");
         return false;
     }
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -207,7 +423,7 @@ bool Game::initializeWindow() {
     // Create a windowed mode window with the dimensions of the monitor
     window = glfwCreateWindow(windowWidth, windowHeight, "Pop Balloons", nullptr, nullptr);
     if (!window) {
-        std::cerr << "Failed to create GLFW window\n";
+        LOG_ERROR("Failed to create GLFW window");
         glfwTerminate();
         return false;
     }
@@ -227,22 +443,22 @@ bool Game::initializeWindow() {
     // Set the frame buffer resize callback
     glfwSetFramebufferSizeCallback(window, [](GLFWwindow* win, int width, int height) {
         if (width == 0 || height == 0) {
-            std::cout << "Resize was called with a zero width or height, ignoring." << std::endl;
+            LOG_DEBUG("Resize was called with a zero width or height, ignoring.");
             return;
         }
 
         Game* game = static_cast<Game*>(glfwGetWindowUserPointer(win));
         if (game) {
-            game->fbWidth = width;
-            game->fbHeight = height;
+            InputEvent event = { InputEvent::Resize, 0.0f, 0.0f, width, height };
+            game->queueInput(event);
             game->renderer.resize(width, height);
-            std::cout << "Framebuffer size updated in game class: " << width << "x" << height << std::endl;
+            LOG_INFO("Framebuffer size updated in game class: %dx%d", width, height);
         }
     });
 
     // Get the framebuffer size
     glfwGetFramebufferSize(window, &fbWidth, &fbHeight);
-    std::cout << "Framebuffer size after window creation: " << fbWidth << "x" << fbHeight << std::endl;
+    LOG_INFO("Framebuffer size after window creation: %dx%d", fbWidth, fbHeight);
 
     return true;
 }
@@ -250,7 +466,7 @@ bool Game::initializeGLEW() {
     // Initialize GLEW
     glewExperimental = GL_TRUE;
     if (GLEW_OK != glewInit()) {
-        std::cerr << "Failed to initialize GLEW\n";
+        LOG_ERROR("Failed to initialize GLEW");
         glfwDestroyWindow(window);
         glfwTerminate();
         return false;
@@ -266,46 +482,37 @@ void Game::setupScene() {
    
     renderer.initialize();
 
-    // Set the initial projection matrix
-    float aspectRatio = static_cast<float>(fbWidth) / static_cast<float>(fbHeight);
-    glm::mat4 projection = glm::ortho(-aspectRatio, aspectRatio, -1.0f, 1.0f);
-
-    renderer.setProjectionMatrix(projection);
+    // Set the initial viewport and projection matrix; later sizes come from the resize callback
+    renderer.resize(fbWidth, fbHeight);
 }
 void Game::updateScene(float deltaTime) {
     // Update each balloon using deltaTime
-    for (auto& balloon : balloons) {
-        balloon.update(deltaTime);
-    }
+    balloons.update(deltaTime);
 
     // Check if any balloons are off-screen and remove them, decreasing lives accordingly
-    balloons.erase(std::remove_if(balloons.begin(), balloons.end(),
-        [this](const Balloon& balloon) {
-            bool isOffScreen = balloon.isOffScreen();
-            if (isOffScreen) {
-                --lives;
-                if (lives <= 0) {
-                    endGame();
-                }
-            }
-            return isOffScreen;
-        }), balloons.end());
+    size_t escaped = balloons.removeOffScreen();
+    if (escaped > 0) {
+        lives -= static_cast<int>(escaped);
+        if (lives <= 0) {
+            endGame();
+        }
+    }
 
     // Check if it's time to create a new balloon
-    double currentTime = glfwGetTime();
-    if (currentTime >= nextBalloonTime) {
+    simulationTime += deltaTime;
+    if (simulationTime >= nextBalloonTime) {
         createBalloon(); // Create a new balloon at random position and color
-        nextBalloonTime = currentTime + balloonSpawnInterval; // Set the time for creating the next balloon
+        nextBalloonTime = simulationTime + balloonSpawnInterval; // Set the time for creating the next balloon
     }
 }
 
-void Game::renderScene() {
+void Game::renderScene(const RenderSnapshot& snapshot, float alpha) {
     // Clear the screen with a specific color (e.g., black)
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     // Delegate the rendering of the balloons to the Renderer class
-    renderer.render(balloons, fragments);
+    renderer.render(snapshot, alpha);
 
 }
 
@@ -317,49 +524,80 @@ void Game::registerClickCallback() {
 
             Game* game = static_cast<Game*>(glfwGetWindowUserPointer(win));
             if (game) {
-                game->handleClick(static_cast<float>(xpos), static_cast<float>(ypos));
+                InputEvent event = { InputEvent::Click, static_cast<float>(xpos), static_cast<float>(ypos), 0, 0 };
+                game->queueInput(event);
+            }
+        }
+    });
+}
+
+// P dumps the recent frame history as a Chrome trace without stopping the game
+void Game::registerKeyCallback() {
+    glfwSetKeyCallback(window, [](GLFWwindow*, int key, int, int action, int) {
+        if (key == GLFW_KEY_P && action == GLFW_PRESS) {
+            const char* path = "popBalloons_trace.json";
+            if (Profiler::writeChromeTrace(path)) {
+                LOG_INFO("Wrote frame trace to %s", path);
+            } else {
+                LOG_ERROR("Could not write frame trace to %s", path);
             }
         }
     });
 }
 
 void Game::handleClick(float xpos, float ypos) {
-    std::cout << "Click received at (" << xpos << ", " << ypos << ")" << std::endl;
+    LOG_DEBUG("Click received at (%f, %f)", xpos, ypos);
     
     // Convert from screen space to normalized device coordinates (NDC)
     float aspectRatio = static_cast<float>(fbWidth) / static_cast<float>(fbHeight);
     float ndcX = (xpos / static_cast<float>(fbWidth)) * 2.0f - 1.0f;
     float ndcY = (ypos / static_cast<float>(fbHeight)) * -2.0f + 1.0f;
 
-    std::cout << "Converted to NDC at (" << ndcX << ", " << ndcY << ")" << std::endl;
+    LOG_DEBUG("Converted to NDC at (%f, %f)", ndcX, ndcY);
     
-    float hitboxScale = 1.5f; 
+    // The projection spans [-aspectRatio, aspectRatio] horizontally, so scale x into world space
+    float worldX = ndcX * aspectRatio;
+    float worldY = ndcY;
 
-    for (size_t i = 0; i < balloons.size(); ++i) {
-        Balloon& balloon = balloons[i];
-        glm::vec3 position = balloon.getPosition();
-
-        // Get the actual size of the balloon
-        float actualRadius = balloon.getSize();
+    float hitboxScale = 1.5f; 
 
-        // Apply the hitbox scale to calculate the effective radius for the hitbox
-        float hitboxRadius = actualRadius * hitboxScale;
+    // Pick the balloon the player actually sees under the cursor
+    size_t hit;
+    if (balloons.findHit(worldX, worldY, hitboxScale, HitPick::Topmost, hit)) {
+        LOG_DEBUG("Balloon %zu popped!", hit);
+        popBalloon(static_cast<int>(hit));
+    }
+}
 
-        float dx = (ndcX - position.x) / aspectRatio;
-        float dy = (ndcY - position.y);
-        float distanceSquared = dx * dx + dy * dy;
+// Only the click mapping depends on the framebuffer; the renderer is resized by the window callback
+void Game::setFramebufferSize(int width, int height) {
+    fbWidth = width;
+    fbHeight = height;
+}
 
-        // Check if the click is within the hitbox radius (squared)
-        if (distanceSquared <= (hitboxRadius * hitboxRadius)) {
-            std::cout << "Balloon " << i << " popped!" << std::endl;
-            popBalloon(i);
-            break;
+uint64_t Game::stateHash() const {
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const void* bytes, size_t count) {
+        const unsigned char* p = static_cast<const unsigned char*>(bytes);
+        for (size_t i = 0; i < count; ++i) {
+            hash = (hash ^ p[i]) * 1099511628211ull;
         }
+    };
+
+    mix(&score, sizeof(score));
+    mix(&lives, sizeof(lives));
+    mix(&simulationTime, sizeof(simulationTime));
+    mix(balloons.getX().data(), balloons.size() * sizeof(float));
+    mix(balloons.getY().data(), balloons.size() * sizeof(float));
+    for (size_t i = 0; i < fragments.size(); ++i) {
+        glm::vec3 position = fragments.getPosition(i);
+        mix(&position, sizeof(position));
     }
+    return hash;
 }
+
 void Game::endGame() {
     // Output final score or trigger game over screen/behavior
-    std::cout << "Game Over! Your score: " << score << std::endl;
-  
-    glfwSetWindowShouldClose(window, GL_TRUE);
+    LOG_INFO("Game Over! Your score: %d", score);
+    gameOver = true; // The render thread closes the window once it sees this in a snapshot
 }
\ No newline at end of file
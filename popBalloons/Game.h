@@ -3,33 +3,107 @@
 
 #include "Renderer.h"
 #include "Balloon.h"
+#include "BalloonPool.h"
 #include "Fragment.h"
+#include "ParticleSystem.h"
+#include "Replay.h"
+#include "RenderSnapshot.h"
+#include "SnapshotMailbox.h"
+#include "SpscQueue.h"
+#include <atomic>
+#include <cstdint>
+#include <thread>
 #include <vector>
 #include <random>
+#include <string>
 
 
+class Clock;
+
+// Window input handed from the GLFW callbacks to the simulation thread
+struct InputEvent {
+    enum Type { Click, Resize };
+    Type type;
+    float x, y;        // Click position in framebuffer pixels
+    int width, height; // New framebuffer size
+};
+
+// A fragment bound for a GPU particle backend, stamped with the simulation time it was spawned at
+struct FragmentEmit {
+    GpuParticle particle;
+    double spawnTime;
+};
+
 class Game {
 public:
     Game();
+    explicit Game(uint32_t seed); // Fixed seed makes a run reproducible from its inputs
     ~Game();
 
     void run();
     void update(float deltaTime);
     void popBalloon(int balloonIndex);
+    bool popHighestBalloon();
     void createBalloon();
+    void reset();
     void cleanup();
+
+    // Input entry points shared by the GLFW callbacks and replay playback
+    void handleClick(float xpos, float ypos);
+    void setFramebufferSize(int width, int height);
+
+    // Chrome trace written when the game loop exits; empty disables it
+    void setTraceOutput(const std::string& path) { traceOutputPath = path; }
+    // Replay of this session's inputs written while the game runs; empty disables it
+    void setRecordOutput(const std::string& path) { recordOutputPath = path; }
+    // Simulation steps per second in run(), independent of the display refresh rate
+    void setTickRate(double ticksPerSecond) { tickInterval = 1.0 / ticksPerSecond; }
+    // Most steps run() takes to catch up after a slow frame; the rest of the backlog is dropped
+    void setMaxCatchUpSteps(int steps) { maxCatchUpSteps = steps; }
+    // How run() draws balloons; falls back to meshes if the SDF shaders do not build
+    void setBalloonShading(BalloonShading shading) { balloonShading = shading; }
+    // Where run() simulates fragments; falls back to the CPU if the backend is unsupported
+    void setParticleBackend(ParticleBackend backend) { particleBackend = backend; }
+
+    // FNV-1a over the simulation state; equal hashes mean a replay reproduced the run
+    uint64_t stateHash() const;
+
+    int getScore() const { return score; }
+    int getLives() const { return lives; }
+    uint32_t getSeed() const { return seed; }
+    bool isGameOver() const { return gameOver; }
+    const BalloonPool& getBalloons() const { return balloons; }
+    const ParticleSystem& getFragments() const { return fragments; }
     
 private:
     Renderer renderer; 
     GLFWwindow* window;
-    std::vector<Balloon> balloons;
-    std::vector<Fragment> fragments;
+    BalloonPool balloons;
+    ParticleSystem fragments;
     int score;
     int lives;
-    double lastTime;
+    bool gameOver;
+    double tickInterval;    // Fixed deltaTime passed to update by run()
+    int maxCatchUpSteps;
+    double simulationTime; // Sum of every deltaTime passed to update
     double nextBalloonTime;
+    uint32_t seed;
     std::mt19937 gen;
     int fbWidth, fbHeight;
+    std::string traceOutputPath;
+    std::string recordOutputPath;
+    ReplayRecorder recorder;
+
+    // run() simulates on simulationThread and renders on the calling thread.
+    // Only the mailbox and the input queue are shared between them.
+    std::thread simulationThread;
+    std::atomic<bool> simulationRunning;
+    SnapshotMailbox<RenderSnapshot> snapshots;
+    SpscQueue<InputEvent, 256> inputQueue;
+    SpscQueue<FragmentEmit, 4096> fragmentEmitQueue; // Fragments popBalloon hands to a GPU backend
+    ParticleBackend particleBackend;
+    BalloonShading balloonShading;
+    uint64_t tickCount;
     
     
     bool initializeGLFW();
@@ -37,10 +111,15 @@ private:
     bool initializeGLEW();
     void setupScene();
     void updateScene(float deltaTime);
-    void renderScene();
+    void renderScene(const RenderSnapshot& snapshot, float alpha);
+    void simulationLoop(const Clock& clock);
+    void applyInput(const InputEvent& event);
+    void publishSnapshot(double stateTime);
+    void queueInput(const InputEvent& event);
     void registerClickCallback(); 
-    void handleClick(float xpos, float ypos); 
+    void registerKeyCallback();
     void endGame();
+    glm::vec3 randomFragmentVelocity();
     float balloonSpeedMultiplier; 
     float balloonSpawnInterval; 
     float balloonSpawnSpeedIncrease; 
@@ -0,0 +1,197 @@
+#include "GpuParticleSystem.h"
+#include "Log.h"
+#include <algorithm>
+#include <cstddef>
+
+namespace {
+
+const float kGravity = -9.8f; // Same as ParticleSystem
+
+} // namespace
+
+GpuParticleSystem::GpuParticleSystem()
+    : shaders(nullptr),
+      updateShader(ShaderRegistry::kInvalidHandle),
+      stateBuffers{ 0, 0 },
+      stateVAOs{ 0, 0 },
+      emitBuffer(0),
+      current(0),
+      capacity(0),
+      head(0),
+      activeSlots(0),
+      longestLifetime(0.0f),
+      sinceLastEmit(0.0f)
+{
+}
+
+GpuParticleSystem::~GpuParticleSystem() {
+    cleanup();
+}
+
+bool GpuParticleSystem::initialize(ShaderRegistry& registry, GLsizei particleCapacity) {
+    const char* varyings[] = { "outPosition", "outVelocity", "outColor", "outSize", "outLifetime" };
+    shaders = &registry;
+    updateShader = shaders->loadTransformFeedback("ParticleUpdate.vertexshader", varyings, 5);
+    if (shaders->program(updateShader) == 0) {
+        LOG_ERROR("GPU particle update shader failed to build");
+        return false;
+    }
+
+    capacity = particleCapacity;
+    glGenBuffers(2, stateBuffers);
+    glGenVertexArrays(2, stateVAOs);
+    for (int i = 0; i < 2; ++i) {
+        glBindBuffer(GL_ARRAY_BUFFER, stateBuffers[i]);
+        glBufferData(GL_ARRAY_BUFFER, capacity * sizeof(GpuParticle), nullptr, GL_DYNAMIC_COPY);
+
+        glBindVertexArray(stateVAOs[i]);
+        glEnableVertexAttribArray(0);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, position));
+        glEnableVertexAttribArray(1);
+        glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, color));
+        glEnableVertexAttribArray(2);
+        glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, size));
+        glEnableVertexAttribArray(3);
+        glVertexAttribPointer(3, 1, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, lifetime));
+        glEnableVertexAttribArray(4);
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(GpuParticle), (void*)offsetof(GpuParticle, velocity));
+    }
+    glBindVertexArray(0);
+
+    glGenBuffers(1, &emitBuffer);
+    glBindBuffer(GL_COPY_READ_BUFFER, emitBuffer);
+    glBufferData(GL_COPY_READ_BUFFER, kEmitCapacity * sizeof(GpuParticle), nullptr, GL_STREAM_DRAW);
+
+    pending.reserve(kEmitCapacity);
+    pendingSpawnTimes.reserve(kEmitCapacity);
+    current = 0;
+    head = 0;
+    activeSlots = 0;
+    return true;
+}
+
+// The update program belongs to the registry and is deleted with it
+void GpuParticleSystem::cleanup() {
+    updateShader = ShaderRegistry::kInvalidHandle;
+    if (stateVAOs[0]) {
+        glDeleteVertexArrays(2, stateVAOs);
+        stateVAOs[0] = stateVAOs[1] = 0;
+    }
+    if (stateBuffers[0]) {
+        glDeleteBuffers(2, stateBuffers);
+        stateBuffers[0] = stateBuffers[1] = 0;
+    }
+    if (emitBuffer) {
+        glDeleteBuffers(1, &emitBuffer);
+        emitBuffer = 0;
+    }
+    pending.clear();
+    pendingSpawnTimes.clear();
+}
+
+void GpuParticleSystem::emit(const GpuParticle& particle, double spawnTime) {
+    pending.push_back(particle);
+    pendingSpawnTimes.push_back(spawnTime);
+}
+
+void GpuParticleSystem::update(float deltaTime, double currentTime) {
+    if (!isInitialized()) {
+        return;
+    }
+
+    // Once the newest particle has expired, every slot has; stop touching them
+    sinceLastEmit += deltaTime;
+    if (activeSlots > 0 && sinceLastEmit > longestLifetime) {
+        activeSlots = 0;
+        head = 0;
+        longestLifetime = 0.0f;
+    }
+    if (activeSlots > 0 && deltaTime > 0.0f) {
+        step(deltaTime);
+    }
+
+    uploadPending(currentTime);
+}
+
+// One transform feedback pass over the slots in use
+void GpuParticleSystem::step(float deltaTime) {
+    // Looked up every step, since a reload can move the uniforms
+    glUseProgram(shaders->program(updateShader));
+    glUniform1f(shaders->uniformLocation(updateShader, "deltaTime"), deltaTime);
+    glUniform1f(shaders->uniformLocation(updateShader, "gravity"), kGravity);
+
+    // Read the latest state, capture the next one into the other buffer
+    glEnable(GL_RASTERIZER_DISCARD);
+    glBindVertexArray(stateVAOs[current]);
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, stateBuffers[1 - current]);
+    glBeginTransformFeedback(GL_POINTS);
+    glDrawArrays(GL_POINTS, 0, activeSlots);
+    glEndTransformFeedback();
+    glBindBufferBase(GL_TRANSFORM_FEEDBACK_BUFFER, 0, 0);
+    glBindVertexArray(0);
+    glDisable(GL_RASTERIZER_DISCARD);
+
+    current = 1 - current;
+}
+
+void GpuParticleSystem::draw() const {
+    if (activeSlots == 0) {
+        return;
+    }
+    glBindVertexArray(stateVAOs[current]);
+    glDrawArrays(GL_POINTS, 0, activeSlots);
+    glBindVertexArray(0);
+}
+
+// Streams the queued particles through the emit buffer into the oldest ring slots
+void GpuParticleSystem::uploadPending(double currentTime) {
+    if (pending.empty()) {
+        return;
+    }
+
+    // Catch each particle up to currentTime with one step of ParticleUpdate's integration
+    for (size_t i = 0; i < pending.size(); ++i) {
+        GpuParticle& particle = pending[i];
+        float age = static_cast<float>(currentTime - pendingSpawnTimes[i]);
+        if (age <= 0.0f || particle.lifetime <= 0.0f) {
+            continue;
+        }
+        particle.position += particle.velocity * age;
+        particle.velocity.y += kGravity * age;
+        particle.color.a = std::max(particle.color.a - age / particle.lifetime, 0.0f);
+        particle.lifetime -= age;
+    }
+
+    // A burst larger than the ring only keeps its newest particles
+    size_t first = pending.size() > static_cast<size_t>(capacity) ? pending.size() - capacity : 0;
+    glBindBuffer(GL_COPY_READ_BUFFER, emitBuffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, stateBuffers[current]);
+    for (size_t begin = first; begin < pending.size(); begin += kEmitCapacity) {
+        GLsizei count = static_cast<GLsizei>(std::min<size_t>(kEmitCapacity, pending.size() - begin));
+        // Orphan so the copy from the previous batch does not have to finish first
+        glBufferData(GL_COPY_READ_BUFFER, kEmitCapacity * sizeof(GpuParticle), nullptr, GL_STREAM_DRAW);
+        glBufferSubData(GL_COPY_READ_BUFFER, 0, count * sizeof(GpuParticle), &pending[begin]);
+        copyIntoRing(0, count);
+    }
+
+    for (size_t i = first; i < pending.size(); ++i) {
+        longestLifetime = std::max(longestLifetime, pending[i].lifetime);
+    }
+    sinceLastEmit = 0.0f;
+    pending.clear();
+    pendingSpawnTimes.clear();
+}
+
+// Copies count particles from the emit buffer to the ring at head, wrapping once if needed
+void GpuParticleSystem::copyIntoRing(GLintptr sourceOffset, GLsizei count) {
+    GLsizei untilEnd = std::min(count, capacity - head);
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                        sourceOffset, head * sizeof(GpuParticle), untilEnd * sizeof(GpuParticle));
+    if (untilEnd < count) {
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER,
+                            sourceOffset + untilEnd * sizeof(GpuParticle), 0, (count - untilEnd) * sizeof(GpuParticle));
+    }
+
+    activeSlots = head + count >= capacity ? capacity : std::max(activeSlots, head + count);
+    head = (head + count) % capacity;
+}
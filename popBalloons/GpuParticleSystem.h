@@ -0,0 +1,80 @@
+#ifndef GPU_PARTICLE_SYSTEM_H
+#define GPU_PARTICLE_SYSTEM_H
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+#include <vector>
+#include "ShaderRegistry.h"
+
+// One fragment as stored on the GPU; the order matches the transform feedback outputs
+struct GpuParticle {
+    glm::vec3 position;
+    glm::vec3 velocity;
+    glm::vec4 color;
+    float size;
+    float lifetime; // Remaining seconds
+};
+
+// Fragment physics on the GPU: particle state lives in two buffers that a
+// transform feedback pass ping-pongs between, so the CPU does no per-particle
+// work at all. Needs only GL 3.3 core (runs on llvmpipe).
+//
+// The buffers are a ring of fixed slots. New particles are staged in a small
+// emit buffer and copied over the oldest slots; expired ones stay in place,
+// skipped by the update and clipped by the draw, until the ring reuses them.
+// Every fragment lives the same short time, so the oldest slot is also the
+// first to expire. Work is proportional to the slots in use, and drops to
+// nothing once everything has expired.
+//
+// Particles are copied in after the step that brings the ring up to the
+// update's time, each first advanced by how long before that it was spawned,
+// so a burst spread over several ticks does not move in lockstep.
+class GpuParticleSystem {
+public:
+    static const GLsizei kDefaultCapacity = 1 << 18;
+    static const GLsizei kEmitCapacity = 4096; // Particles per emit buffer upload
+
+    GpuParticleSystem();
+    ~GpuParticleSystem();
+
+    // Builds the update program in shaders, which keeps it reloadable, and the buffers;
+    // false if transform feedback is unusable
+    bool initialize(ShaderRegistry& shaders, GLsizei capacity = kDefaultCapacity);
+    void cleanup();
+    bool isInitialized() const { return stateBuffers[0] != 0; }
+
+    // Queued until the next update(); spawnTime is on the same clock as update's currentTime
+    void emit(const GpuParticle& particle, double spawnTime);
+    // Advances every slot in use by deltaTime to currentTime, then uploads the queued particles
+    void update(float deltaTime, double currentTime);
+    // Draws the slots in use as points; attributes 0-3 match SimpleVertexShader's
+    void draw() const;
+
+    GLsizei getActiveSlots() const { return activeSlots; }
+    // The buffer holding the latest state, read back by the gpu_particles_match_cpu test
+    GLuint getStateBuffer() const { return stateBuffers[current]; }
+
+private:
+    void step(float deltaTime);
+    void uploadPending(double currentTime);
+    void copyIntoRing(GLintptr sourceOffset, GLsizei count);
+
+    ShaderRegistry* shaders;
+    ShaderRegistry::Handle updateShader;
+
+    GLuint stateBuffers[2];
+    GLuint stateVAOs[2]; // Same layout over each state buffer, for both the update and the draw
+    GLuint emitBuffer;
+    int current;         // Index of the buffer with the latest state
+
+    GLsizei capacity;
+    GLsizei head;        // Next slot to overwrite
+    GLsizei activeSlots; // Slots [0, activeSlots) have been written at least once
+    float longestLifetime; // Of the particles emitted so far
+    float sinceLastEmit;   // Seconds simulated since the newest particle was emitted
+
+    std::vector<GpuParticle> pending;
+    std::vector<double> pendingSpawnTimes; // One per pending particle
+};
+
+#endif // GPU_PARTICLE_SYSTEM_H
@@ -0,0 +1,58 @@
+#include "Headless.h"
+#include "Game.h"
+#include <thread>
+
+HeadlessRunner::HeadlessRunner(Game& game, Clock& clock)
+    : game(game), clock(clock) {
+}
+
+HeadlessStats HeadlessRunner::run(const HeadlessConfig& config) {
+    HeadlessStats stats;
+    const float deltaTime = static_cast<float>(config.fixedDeltaTime);
+    const double startTime = clock.now();
+    stats.gamesPlayed = 1;
+
+    while (config.maxTicks == 0 || stats.ticks < config.maxTicks) {
+        if (config.ticksPerSecond > 0.0) {
+            waitForTick(startTime + static_cast<double>(stats.ticks) / config.ticksPerSecond);
+        }
+
+        // Stand in for the player so spawning, popping and scoring all get exercised
+        if (config.autoPopInterval > 0 && stats.ticks % config.autoPopInterval == 0) {
+            if (game.popHighestBalloon()) {
+                ++stats.balloonsPopped;
+            }
+        }
+
+        game.update(deltaTime);
+        ++stats.ticks;
+
+        if (game.isGameOver()) {
+            stats.lastScore = game.getScore();
+            if (!config.restartOnGameOver || config.maxTicks == 0) {
+                break;
+            }
+            game.reset();
+            ++stats.gamesPlayed;
+        }
+    }
+
+    if (!game.isGameOver()) {
+        stats.lastScore = game.getScore();
+    }
+    stats.wallSeconds = clock.now() - startTime;
+    return stats;
+}
+
+void HeadlessRunner::waitForTick(double tickTime) {
+    // Sleep off most of the wait, then spin for the last stretch to keep the tick rate steady
+    double remaining = tickTime - clock.now();
+    while (remaining > 0.0) {
+        if (remaining > 0.002) {
+            std::this_thread::sleep_for(std::chrono::duration<double>(remaining - 0.001));
+        } else {
+            std::this_thread::yield();
+        }
+        remaining = tickTime - clock.now();
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+#include <cstdint>
+#include "Clock.h"
+
+class Game;
+
+struct HeadlessConfig {
+    double fixedDeltaTime = 1.0 / 60.0; // Simulation step fed to Game::update
+    double ticksPerSecond = 0.0;        // Wall-clock pacing; 0 runs as fast as possible
+    uint64_t maxTicks = 0;              // 0 runs until the game is over
+    unsigned int autoPopInterval = 0;   // Pop the highest balloon every N ticks; 0 never clicks
+    bool restartOnGameOver = false;     // Start a new game instead of stopping (needs maxTicks)
+};
+
+struct HeadlessStats {
+    uint64_t ticks = 0;
+    uint64_t gamesPlayed = 0;
+    uint64_t balloonsPopped = 0;
+    int lastScore = 0;
+    double wallSeconds = 0.0;
+};
+
+// Steps a Game without a window, a GL context or GLFW.
+// The simulation always advances by the fixed step; the injected clock is only
+// used to pace ticks in real time and to measure how long the run took.
+class HeadlessRunner {
+public:
+    HeadlessRunner(Game& game, Clock& clock);
+
+    HeadlessStats run(const HeadlessConfig& config);
+
+private:
+    void waitForTick(double tickTime);
+
+    Game& game;
+    Clock& clock;
+};
+
+#endif // HEADLESS_H
@@ -0,0 +1,177 @@
+#include "Log.h"
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+
+namespace {
+
+const size_t kRingSize = 1024; // Must be a power of two
+const size_t kMessageSize = 240;
+
+// One message. sequence tells producers and the consumer who owns the slot:
+// == position      -> free for the producer claiming that position
+// == position + 1  -> written, waiting for the drain thread
+struct Slot {
+    std::atomic<size_t> sequence;
+    LogLevel level;
+    char text[kMessageSize];
+};
+
+const char* levelName(LogLevel level) {
+    switch (level) {
+    case LogLevel::Trace: return "TRACE";
+    case LogLevel::Debug: return "DEBUG";
+    case LogLevel::Info:  return "INFO";
+    case LogLevel::Warn:  return "WARN";
+    case LogLevel::Error: return "ERROR";
+    }
+    return "?";
+}
+
+// Bounded multi-producer/single-consumer ring with a dedicated drain thread
+class Logger {
+public:
+    Logger()
+        : tail(0),
+          head(0),
+          dropped(0),
+          threshold(POPBALLOONS_LOG_LEVEL),
+          running(true)
+    {
+        for (size_t i = 0; i < kRingSize; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        drainThread = std::thread(&Logger::drainLoop, this);
+    }
+
+    ~Logger() {
+        running.store(false, std::memory_order_release);
+        drainThread.join();
+        drain();
+
+        unsigned long long lost = dropped.load(std::memory_order_relaxed);
+        if (lost > 0) {
+            fprintf(stderr, "[WARN] %llu log messages were dropped because the log ring was full\n", lost);
+        }
+    }
+
+    void write(LogLevel level, const char* format, va_list args) {
+        // Claim a slot without locking; give up instead of waiting when the ring is full
+        size_t position = tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots[position & (kRingSize - 1)];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (diff == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->level = level;
+        vsnprintf(slot->text, kMessageSize, format, args);
+        slot->sequence.store(position + 1, std::memory_order_release);
+    }
+
+    void flush() {
+        size_t target = tail.load(std::memory_order_acquire);
+        while (head.load(std::memory_order_acquire) < target) {
+            std::this_thread::yield();
+        }
+    }
+
+    void setThreshold(LogLevel level) { threshold.store(static_cast<int>(level), std::memory_order_relaxed); }
+    int getThreshold() const { return threshold.load(std::memory_order_relaxed); }
+    unsigned long long droppedCount() const { return dropped.load(std::memory_order_relaxed); }
+
+private:
+    // Writes out every published message in order; only ever run by one thread at a time
+    size_t drain() {
+        size_t written = 0;
+        size_t position = head.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[position & (kRingSize - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+                break;
+            }
+
+            FILE* out = slot.level >= LogLevel::Warn ? stderr : stdout;
+            fprintf(out, "[%s] %s\n", levelName(slot.level), slot.text);
+
+            slot.sequence.store(position + kRingSize, std::memory_order_release);
+            ++position;
+            ++written;
+            head.store(position, std::memory_order_release);
+        }
+
+        if (written > 0) {
+            fflush(stdout);
+            fflush(stderr);
+        }
+        return written;
+    }
+
+    void drainLoop() {
+        while (running.load(std::memory_order_acquire)) {
+            if (drain() == 0) {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+        }
+    }
+
+    Slot slots[kRingSize];
+    std::atomic<size_t> tail; // Next position a producer will claim
+    std::atomic<size_t> head; // Next position the drain thread will write out
+    std::atomic<unsigned long long> dropped;
+    std::atomic<int> threshold;
+    std::atomic<bool> running;
+    std::thread drainThread;
+};
+
+Logger& logger() {
+    static Logger instance;
+    return instance;
+}
+
+} // namespace
+
+namespace Log {
+
+void write(LogLevel level, const char* format, ...) {
+    if (!isEnabled(level)) {
+        return;
+    }
+
+    va_list args;
+    va_start(args, format);
+    logger().write(level, format, args);
+    va_end(args);
+}
+
+void setLevel(LogLevel level) {
+    logger().setThreshold(level);
+}
+
+bool isEnabled(LogLevel level) {
+    return static_cast<int>(level) >= logger().getThreshold();
+}
+
+void flush() {
+    logger().flush();
+}
+
+unsigned long long droppedCount() {
+    return logger().droppedCount();
+}
+
+} // namespace Log
@@ -0,0 +1,82 @@
+#ifndef LOG_H
+#define LOG_H
+
+// Leveled logging that never blocks the caller.
+// Messages are formatted straight into a slot of a lock-free ring buffer and a
+// background thread writes them out. When the ring is full the message is
+// dropped and counted rather than stalling the frame.
+//
+// POPBALLOONS_LOG_LEVEL removes every call below that level at compile time,
+// so e.g. LOG_TRACE in Balloon::update costs nothing in a normal build.
+
+#define POPBALLOONS_LOG_LEVEL_TRACE 0
+#define POPBALLOONS_LOG_LEVEL_DEBUG 1
+#define POPBALLOONS_LOG_LEVEL_INFO  2
+#define POPBALLOONS_LOG_LEVEL_WARN  3
+#define POPBALLOONS_LOG_LEVEL_ERROR 4
+#define POPBALLOONS_LOG_LEVEL_OFF   5
+
+#ifndef POPBALLOONS_LOG_LEVEL
+#define POPBALLOONS_LOG_LEVEL POPBALLOONS_LOG_LEVEL_INFO
+#endif
+
+enum class LogLevel {
+    Trace = POPBALLOONS_LOG_LEVEL_TRACE,
+    Debug = POPBALLOONS_LOG_LEVEL_DEBUG,
+    Info  = POPBALLOONS_LOG_LEVEL_INFO,
+    Warn  = POPBALLOONS_LOG_LEVEL_WARN,
+    Error = POPBALLOONS_LOG_LEVEL_ERROR
+};
+
+namespace Log {
+
+// printf-style; safe to call from any thread
+void write(LogLevel level, const char* format, ...)
+#if defined(__GNUC__)
+    __attribute__((format(printf, 2, 3)))
+#endif
+    ;
+
+// Runtime threshold on top of the compile-time one
+void setLevel(LogLevel level);
+bool isEnabled(LogLevel level);
+
+// Blocks until everything queued so far has been written
+void flush();
+
+// Number of messages lost because the ring buffer was full
+unsigned long long droppedCount();
+
+} // namespace Log
+
+#if POPBALLOONS_LOG_LEVEL <= POPBALLOONS_LOG_LEVEL_TRACE
+#define LOG_TRACE(...) Log::write(LogLevel::Trace, __VA_ARGS__)
+#else
+#define LOG_TRACE(...) ((void)0)
+#endif
+
+#if POPBALLOONS_LOG_LEVEL <= POPBALLOONS_LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) Log::write(LogLevel::Debug, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if POPBALLOONS_LOG_LEVEL <= POPBALLOONS_LOG_LEVEL_INFO
+#define LOG_INFO(...) Log::write(LogLevel::Info, __VA_ARGS__)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if POPBALLOONS_LOG_LEVEL <= POPBALLOONS_LOG_LEVEL_WARN
+#define LOG_WARN(...) Log::write(LogLevel::Warn, __VA_ARGS__)
+#else
+#define LOG_WARN(...) ((void)0)
+#endif
+
+#if POPBALLOONS_LOG_LEVEL <= POPBALLOONS_LOG_LEVEL_ERROR
+#define LOG_ERROR(...) Log::write(LogLevel::Error, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#endif // LOG_H
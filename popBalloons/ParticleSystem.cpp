@@ -0,0 +1,169 @@
+#include "ParticleSystem.h"
+
+#if !defined(POPBALLOONS_NO_SIMD)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define PARTICLE_KERNEL_AVX2
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define PARTICLE_KERNEL_SSE2
+#endif
+#endif
+
+namespace {
+
+const float kGravity = -9.8f;
+
+// Reference integration step, also used for the tail that does not fill a SIMD register.
+// Matches the original per-Fragment loop: move, apply gravity, fade alpha, age.
+void integrateScalar(size_t begin, size_t end, float deltaTime,
+                     float* px, float* py, float* pz,
+                     const float* vx, float* vy, const float* vz,
+                     float* a, float* lifetime) {
+    const float gravityStep = kGravity * deltaTime;
+    for (size_t i = begin; i < end; ++i) {
+        px[i] += vx[i] * deltaTime;
+        py[i] += vy[i] * deltaTime;
+        pz[i] += vz[i] * deltaTime;
+        vy[i] += gravityStep;
+
+        float faded = a[i] - deltaTime / lifetime[i];
+        a[i] = faded > 0.0f ? faded : 0.0f;
+        lifetime[i] -= deltaTime;
+    }
+}
+
+} // namespace
+
+void ParticleSystem::reserve(size_t capacity) {
+    px.reserve(capacity); py.reserve(capacity); pz.reserve(capacity);
+    prevX.reserve(capacity); prevY.reserve(capacity); prevZ.reserve(capacity);
+    vx.reserve(capacity); vy.reserve(capacity); vz.reserve(capacity);
+    r.reserve(capacity); g.reserve(capacity); b.reserve(capacity); a.reserve(capacity);
+    sizes.reserve(capacity);
+    lifetime.reserve(capacity);
+}
+
+void ParticleSystem::clear() {
+    px.clear(); py.clear(); pz.clear();
+    prevX.clear(); prevY.clear(); prevZ.clear();
+    vx.clear(); vy.clear(); vz.clear();
+    r.clear(); g.clear(); b.clear(); a.clear();
+    sizes.clear();
+    lifetime.clear();
+}
+
+void ParticleSystem::emit(const Fragment& fragment) {
+    px.push_back(fragment.position.x);
+    py.push_back(fragment.position.y);
+    pz.push_back(fragment.position.z);
+    prevX.push_back(fragment.position.x);
+    prevY.push_back(fragment.position.y);
+    prevZ.push_back(fragment.position.z);
+    vx.push_back(fragment.velocity.x);
+    vy.push_back(fragment.velocity.y);
+    vz.push_back(fragment.velocity.z);
+    r.push_back(fragment.color.r);
+    g.push_back(fragment.color.g);
+    b.push_back(fragment.color.b);
+    a.push_back(fragment.color.a);
+    sizes.push_back(fragment.size);
+    lifetime.push_back(fragment.lifetime);
+}
+
+void ParticleSystem::update(float deltaTime) {
+    if (lifetime.empty()) {
+        return;
+    }
+
+    prevX.assign(px.begin(), px.end());
+    prevY.assign(py.begin(), py.end());
+    prevZ.assign(pz.begin(), pz.end());
+    integrate(deltaTime);
+    compact();
+}
+
+void ParticleSystem::integrate(float deltaTime) {
+    const size_t count = lifetime.size();
+    size_t i = 0;
+
+#if defined(PARTICLE_KERNEL_AVX2)
+    const __m256 dt = _mm256_set1_ps(deltaTime);
+    const __m256 gravityStep = _mm256_set1_ps(kGravity * deltaTime);
+    const __m256 zero = _mm256_setzero_ps();
+    for (; i + 8 <= count; i += 8) {
+        __m256 velY = _mm256_loadu_ps(&vy[i]);
+        _mm256_storeu_ps(&px[i], _mm256_add_ps(_mm256_loadu_ps(&px[i]), _mm256_mul_ps(_mm256_loadu_ps(&vx[i]), dt)));
+        _mm256_storeu_ps(&py[i], _mm256_add_ps(_mm256_loadu_ps(&py[i]), _mm256_mul_ps(velY, dt)));
+        _mm256_storeu_ps(&pz[i], _mm256_add_ps(_mm256_loadu_ps(&pz[i]), _mm256_mul_ps(_mm256_loadu_ps(&vz[i]), dt)));
+        _mm256_storeu_ps(&vy[i], _mm256_add_ps(velY, gravityStep));
+
+        __m256 life = _mm256_loadu_ps(&lifetime[i]);
+        __m256 faded = _mm256_sub_ps(_mm256_loadu_ps(&a[i]), _mm256_div_ps(dt, life));
+        _mm256_storeu_ps(&a[i], _mm256_max_ps(faded, zero));
+        _mm256_storeu_ps(&lifetime[i], _mm256_sub_ps(life, dt));
+    }
+#elif defined(PARTICLE_KERNEL_SSE2)
+    const __m128 dt = _mm_set1_ps(deltaTime);
+    const __m128 gravityStep = _mm_set1_ps(kGravity * deltaTime);
+    const __m128 zero = _mm_setzero_ps();
+    for (; i + 4 <= count; i += 4) {
+        __m128 velY = _mm_loadu_ps(&vy[i]);
+        _mm_storeu_ps(&px[i], _mm_add_ps(_mm_loadu_ps(&px[i]), _mm_mul_ps(_mm_loadu_ps(&vx[i]), dt)));
+        _mm_storeu_ps(&py[i], _mm_add_ps(_mm_loadu_ps(&py[i]), _mm_mul_ps(velY, dt)));
+        _mm_storeu_ps(&pz[i], _mm_add_ps(_mm_loadu_ps(&pz[i]), _mm_mul_ps(_mm_loadu_ps(&vz[i]), dt)));
+        _mm_storeu_ps(&vy[i], _mm_add_ps(velY, gravityStep));
+
+        __m128 life = _mm_loadu_ps(&lifetime[i]);
+        __m128 faded = _mm_sub_ps(_mm_loadu_ps(&a[i]), _mm_div_ps(dt, life));
+        _mm_storeu_ps(&a[i], _mm_max_ps(faded, zero));
+        _mm_storeu_ps(&lifetime[i], _mm_sub_ps(life, dt));
+    }
+#endif
+
+    integrateScalar(i, count, deltaTime,
+                    px.data(), py.data(), pz.data(),
+                    vx.data(), vy.data(), vz.data(),
+                    a.data(), lifetime.data());
+}
+
+void ParticleSystem::compact() {
+    // Slide every surviving particle down over the dead ones, then trim once
+    const size_t count = lifetime.size();
+    size_t alive = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (lifetime[i] <= 0.0f) {
+            continue;
+        }
+        if (alive != i) {
+            px[alive] = px[i]; py[alive] = py[i]; pz[alive] = pz[i];
+            prevX[alive] = prevX[i]; prevY[alive] = prevY[i]; prevZ[alive] = prevZ[i];
+            vx[alive] = vx[i]; vy[alive] = vy[i]; vz[alive] = vz[i];
+            r[alive] = r[i]; g[alive] = g[i]; b[alive] = b[i]; a[alive] = a[i];
+            sizes[alive] = sizes[i];
+            lifetime[alive] = lifetime[i];
+        }
+        ++alive;
+    }
+
+    if (alive == count) {
+        return;
+    }
+
+    px.resize(alive); py.resize(alive); pz.resize(alive);
+    prevX.resize(alive); prevY.resize(alive); prevZ.resize(alive);
+    vx.resize(alive); vy.resize(alive); vz.resize(alive);
+    r.resize(alive); g.resize(alive); b.resize(alive); a.resize(alive);
+    sizes.resize(alive);
+    lifetime.resize(alive);
+}
+
+const char* ParticleSystem::kernelName() {
+#if defined(PARTICLE_KERNEL_AVX2)
+    return "AVX2";
+#elif defined(PARTICLE_KERNEL_SSE2)
+    return "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,45 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <glm/glm.hpp>
+#include <vector>
+#include <cstddef>
+#include "Fragment.h"
+
+// Structure-of-arrays storage for explosion fragments.
+// update() integrates every live particle with the widest SIMD kernel the build
+// targets (AVX2, SSE2, or scalar when POPBALLOONS_NO_SIMD is defined) and then
+// compacts the survivors in a single pass, keeping their relative order.
+// Positions from before the last update() are kept for render interpolation.
+class ParticleSystem {
+public:
+    void reserve(size_t capacity);
+    void clear();
+
+    void emit(const Fragment& fragment);
+    void update(float deltaTime);
+
+    size_t size() const { return lifetime.size(); }
+    bool empty() const { return lifetime.empty(); }
+
+    glm::vec3 getPosition(size_t index) const { return glm::vec3(px[index], py[index], pz[index]); }
+    glm::vec3 getPreviousPosition(size_t index) const { return glm::vec3(prevX[index], prevY[index], prevZ[index]); }
+    glm::vec4 getColor(size_t index) const { return glm::vec4(r[index], g[index], b[index], a[index]); }
+    float getSize(size_t index) const { return sizes[index]; }
+    float getLifetime(size_t index) const { return lifetime[index]; }
+
+    static const char* kernelName();
+
+private:
+    void integrate(float deltaTime);
+    void compact();
+
+    std::vector<float> px, py, pz; // Position
+    std::vector<float> prevX, prevY, prevZ; // Position before the last update; equal to px, py, pz for new fragments
+    std::vector<float> vx, vy, vz; // Velocity
+    std::vector<float> r, g, b, a; // RGBA color, A fades out over the lifetime
+    std::vector<float> sizes;
+    std::vector<float> lifetime;   // Remaining time before the fragment is removed
+};
+
+#endif // PARTICLE_SYSTEM_H
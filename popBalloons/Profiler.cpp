@@ -0,0 +1,321 @@
+#include "Profiler.h"
+#include <GL/glew.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+
+namespace {
+
+const int kMaxDepth = 16;
+const int kGpuLatency = 4; // Frames a GPU query gets before its result is read back
+
+struct Zone {
+    const char* name;
+    uint64_t start;    // Microseconds since the profiler started
+    uint64_t duration; // Microseconds
+    int depth;
+    int gpuQuery;      // Slot in the frame's query set, -1 for CPU zones
+    bool resolved;     // False while a GPU zone is still waiting on its query
+};
+
+struct Frame {
+    uint64_t number;
+    uint64_t start;
+    uint64_t duration;
+    int zoneCount;
+    int gpuZoneCount;
+    Zone zones[Profiler::kMaxZonesPerFrame];
+};
+
+// One recording thread's frames. Only that thread writes to it, and only while
+// holding frameMutex, which it keeps from beginFrame to endFrame so a trace
+// written from another thread never sees a half-recorded frame.
+struct Track {
+    const char* name = nullptr;
+    std::mutex frameMutex;
+    Frame frames[Profiler::kFrameHistory];
+    uint64_t framesBegun = 0;
+    bool inFrame = false;
+
+    int openZones[kMaxDepth]; // Index into the frame's zones, -1 for a dropped zone
+    int depth = 0;
+};
+
+struct State {
+    Track tracks[Profiler::kMaxThreads];
+    std::atomic<int> trackCount{0};
+    std::mutex registerMutex;
+
+    int gpuTrack = -1;        // The track of the thread that owns the GL context
+    int openGpuZone = -1;     // -1 none, -2 dropped
+    bool gpuReady = false;
+    GLuint queries[kGpuLatency][Profiler::kMaxGpuZonesPerFrame];
+
+    std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+};
+
+State& state() {
+    static State instance;
+    return instance;
+}
+
+thread_local int threadTrack = -1;
+
+// The calling thread's track, registered on first use; -1 once every track is taken
+int trackIndex() {
+    if (threadTrack < 0) {
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.registerMutex);
+        int index = s.trackCount.load(std::memory_order_relaxed);
+        if (index < Profiler::kMaxThreads) {
+            s.trackCount.store(index + 1, std::memory_order_release);
+            threadTrack = index;
+        }
+    }
+    return threadTrack;
+}
+
+Track* currentTrack() {
+    int index = trackIndex();
+    return index >= 0 ? &state().tracks[index] : nullptr;
+}
+
+uint64_t nowMicros() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - state().epoch).count());
+}
+
+Frame& currentFrame(Track& track) {
+    return track.frames[(track.framesBegun - 1) % Profiler::kFrameHistory];
+}
+
+// Reads back the GPU zones of a frame whose query set is about to be reused
+void resolveGpuZones(Track& track, uint64_t frameNumber) {
+    State& s = state();
+    Frame& frame = track.frames[frameNumber % Profiler::kFrameHistory];
+    if (frame.number != frameNumber) {
+        return;
+    }
+
+    for (int i = 0; i < frame.zoneCount; ++i) {
+        Zone& zone = frame.zones[i];
+        if (zone.gpuQuery < 0 || zone.resolved) {
+            continue;
+        }
+        // After kGpuLatency frames the result is almost always ready, so this rarely blocks
+        GLuint64 elapsedNanoseconds = 0;
+        glGetQueryObjectui64v(s.queries[frameNumber % kGpuLatency][zone.gpuQuery], GL_QUERY_RESULT, &elapsedNanoseconds);
+        zone.duration = elapsedNanoseconds / 1000;
+        zone.resolved = true;
+    }
+}
+
+int openZone(Track& track, const char* name, int gpuQuery) {
+    Frame& frame = currentFrame(track);
+    if (frame.zoneCount >= Profiler::kMaxZonesPerFrame) {
+        return -1;
+    }
+
+    int index = frame.zoneCount++;
+    Zone& zone = frame.zones[index];
+    zone.name = name;
+    zone.start = nowMicros();
+    zone.duration = 0;
+    zone.depth = track.depth;
+    zone.gpuQuery = gpuQuery;
+    zone.resolved = gpuQuery < 0;
+    return index;
+}
+
+void writeEvent(FILE* file, bool& first, const char* name, const char* category, int thread,
+                uint64_t start, uint64_t duration) {
+    fprintf(file, "%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%llu,\"dur\":%llu}",
+            first ? "" : ",", name, category, thread,
+            static_cast<unsigned long long>(start), static_cast<unsigned long long>(duration));
+    first = false;
+}
+
+} // namespace
+
+namespace Profiler {
+
+void setThreadName(const char* name) {
+    Track* track = currentTrack();
+    if (track) {
+        track->name = name;
+    }
+}
+
+void initializeGpu() {
+    State& s = state();
+    glGenQueries(kGpuLatency * kMaxGpuZonesPerFrame, &s.queries[0][0]);
+    s.gpuTrack = trackIndex();
+    s.gpuReady = s.gpuTrack >= 0;
+}
+
+void cleanupGpu() {
+    State& s = state();
+    if (s.gpuReady) {
+        glDeleteQueries(kGpuLatency * kMaxGpuZonesPerFrame, &s.queries[0][0]);
+        s.gpuReady = false;
+    }
+}
+
+void beginFrame() {
+    Track* track = currentTrack();
+    if (!track || track->inFrame) {
+        return;
+    }
+
+    State& s = state();
+    track->frameMutex.lock();
+    uint64_t number = track->framesBegun;
+    bool ownsGpu = s.gpuReady && trackIndex() == s.gpuTrack;
+    if (ownsGpu && number >= static_cast<uint64_t>(kGpuLatency)) {
+        resolveGpuZones(*track, number - kGpuLatency);
+    }
+
+    Frame& frame = track->frames[number % kFrameHistory];
+    frame.number = number;
+    frame.start = nowMicros();
+    frame.duration = 0;
+    frame.zoneCount = 0;
+    frame.gpuZoneCount = 0;
+
+    track->framesBegun = number + 1;
+    track->inFrame = true;
+    track->depth = 0;
+    if (ownsGpu) {
+        s.openGpuZone = -1;
+    }
+}
+
+void endFrame() {
+    Track* track = currentTrack();
+    if (!track || !track->inFrame) {
+        return;
+    }
+
+    Frame& frame = currentFrame(*track);
+    frame.duration = nowMicros() - frame.start;
+    track->inFrame = false;
+    track->frameMutex.unlock();
+}
+
+void beginZone(const char* name) {
+    Track* track = currentTrack();
+    if (!track || !track->inFrame || track->depth >= kMaxDepth) {
+        return;
+    }
+
+    track->openZones[track->depth] = openZone(*track, name, -1);
+    ++track->depth;
+}
+
+void endZone() {
+    Track* track = currentTrack();
+    if (!track || !track->inFrame || track->depth == 0) {
+        return;
+    }
+
+    int index = track->openZones[--track->depth];
+    if (index >= 0) {
+        Zone& zone = currentFrame(*track).zones[index];
+        zone.duration = nowMicros() - zone.start;
+    }
+}
+
+void beginGpuZone(const char* name) {
+    State& s = state();
+    Track* track = currentTrack();
+    if (!track || !track->inFrame || trackIndex() != s.gpuTrack) {
+        return;
+    }
+
+    Frame& frame = currentFrame(*track);
+    if (!s.gpuReady || s.openGpuZone != -1 || frame.gpuZoneCount >= kMaxGpuZonesPerFrame) {
+        s.openGpuZone = -2;
+        return;
+    }
+
+    int query = frame.gpuZoneCount;
+    int index = openZone(*track, name, query);
+    if (index < 0) {
+        s.openGpuZone = -2;
+        return;
+    }
+
+    ++frame.gpuZoneCount;
+    glBeginQuery(GL_TIME_ELAPSED, s.queries[frame.number % kGpuLatency][query]);
+    s.openGpuZone = index;
+}
+
+void endGpuZone() {
+    State& s = state();
+    if (trackIndex() != s.gpuTrack) {
+        return;
+    }
+    if (s.openGpuZone >= 0) {
+        glEndQuery(GL_TIME_ELAPSED);
+    }
+    s.openGpuZone = -1;
+}
+
+bool writeChromeTrace(const char* path) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        return false;
+    }
+
+    State& s = state();
+    const int gpuThread = kMaxThreads + 1;
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+    fprintf(file, "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"GPU\"}}", gpuThread);
+    bool first = false;
+
+    // Each recording thread gets its own trace thread, numbered from 1 in the order they first recorded
+    int trackCount = s.trackCount.load(std::memory_order_acquire);
+    for (int t = 0; t < trackCount; ++t) {
+        Track& track = s.tracks[t];
+        const int thread = t + 1;
+
+        // The caller's own track is mid-frame when this runs from a key callback; its frame stays open
+        bool own = t == threadTrack;
+        if (!own) {
+            track.frameMutex.lock();
+        }
+
+        if (track.name) {
+            fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", thread, track.name);
+        }
+
+        uint64_t available = track.framesBegun < static_cast<uint64_t>(kFrameHistory) ? track.framesBegun : kFrameHistory;
+        uint64_t firstFrame = track.framesBegun - available;
+        uint64_t endFrameNumber = track.inFrame ? track.framesBegun - 1 : track.framesBegun; // Skip a frame still being recorded
+
+        for (uint64_t number = firstFrame; number < endFrameNumber; ++number) {
+            const Frame& frame = track.frames[number % kFrameHistory];
+            writeEvent(file, first, "frame", "frame", thread, frame.start, frame.duration);
+
+            for (int i = 0; i < frame.zoneCount; ++i) {
+                const Zone& zone = frame.zones[i];
+                if (zone.gpuQuery < 0) {
+                    writeEvent(file, first, zone.name, "cpu", thread, zone.start, zone.duration);
+                } else if (zone.resolved) {
+                    // GPU work is placed where it was submitted; only its length is measured
+                    writeEvent(file, first, zone.name, "gpu", gpuThread, zone.start, zone.duration);
+                }
+            }
+        }
+
+        if (!own) {
+            track.frameMutex.unlock();
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    return fclose(file) == 0;
+}
+
+} // namespace Profiler
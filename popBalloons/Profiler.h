@@ -0,0 +1,61 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <cstdint>
+
+// Frame profiler with nested CPU zones and GL_TIME_ELAPSED GPU zones.
+// Every frame's zones are kept in a fixed ring of the last kFrameHistory frames,
+// which can be written out as Chrome trace_event JSON (chrome://tracing, Perfetto).
+//
+// Every thread that calls beginFrame/endFrame records its own frames and zones
+// and shows up as its own thread in the trace; zones outside a frame are ignored.
+// GPU zones are only recorded on the thread that called initializeGpu. They
+// must not nest inside each other (GL allows one active TIME_ELAPSED query) and
+// are resolved a few frames later, once the GPU has caught up.
+namespace Profiler {
+
+const int kMaxThreads = 4;         // Threads past this many are not recorded
+const int kFrameHistory = 600;     // Ten seconds at 60 Hz
+const int kMaxZonesPerFrame = 32;  // Extra zones in a frame are dropped
+const int kMaxGpuZonesPerFrame = 4;
+
+// Names the calling thread in the trace; name must outlive the profiler
+void setThreadName(const char* name);
+
+// Creates the GPU query pool for the calling thread; without it GPU zones are skipped
+void initializeGpu();
+void cleanupGpu();
+
+void beginFrame();
+void endFrame();
+
+void beginZone(const char* name);
+void endZone();
+void beginGpuZone(const char* name);
+void endGpuZone();
+
+// Writes every frame still in the history ring; returns false if the file can't be written
+bool writeChromeTrace(const char* path);
+
+class Scope {
+public:
+    explicit Scope(const char* name) { beginZone(name); }
+    ~Scope() { endZone(); }
+};
+
+class GpuScope {
+public:
+    explicit GpuScope(const char* name) { beginGpuZone(name); }
+    ~GpuScope() { endGpuZone(); }
+};
+
+} // namespace Profiler
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// Name must be a string literal (or otherwise outlive the history ring)
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_GPU_SCOPE(name) Profiler::GpuScope PROFILE_CONCAT(profileGpuScope, __LINE__)(name)
+
+#endif // PROFILER_H
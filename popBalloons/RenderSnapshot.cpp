@@ -0,0 +1,78 @@
+#include "RenderSnapshot.h"
+#include "BalloonPool.h"
+#include "ParticleSystem.h"
+#include <algorithm>
+
+namespace {
+
+// Hands the array's storage back so the arena can be reset under it
+template <typename T>
+void release(ArenaVector<T>& array) {
+    ArenaVector<T>(array.get_allocator()).swap(array);
+}
+
+} // namespace
+
+RenderSnapshot::RenderSnapshot()
+    : arena(256 * 1024),
+      balloonPosition(ArenaAllocator<glm::vec2>(arena)),
+      balloonPreviousPosition(ArenaAllocator<glm::vec2>(arena)),
+      balloonSize(ArenaAllocator<float>(arena)),
+      balloonColor(ArenaAllocator<glm::vec3>(arena)),
+      fragmentPosition(ArenaAllocator<glm::vec3>(arena)),
+      fragmentPreviousPosition(ArenaAllocator<glm::vec3>(arena)),
+      fragmentColor(ArenaAllocator<glm::vec4>(arena)),
+      fragmentSize(ArenaAllocator<float>(arena))
+{
+}
+
+void RenderSnapshot::capture(const BalloonPool& balloons, const ParticleSystem& fragments) {
+    release(balloonPosition);
+    release(balloonPreviousPosition);
+    release(balloonSize);
+    release(balloonColor);
+    release(fragmentPosition);
+    release(fragmentPreviousPosition);
+    release(fragmentColor);
+    release(fragmentSize);
+    arena.reset();
+
+    const size_t balloonCount = balloons.size();
+    const std::vector<float>& x = balloons.getX();
+    const std::vector<float>& y = balloons.getY();
+    const std::vector<float>& previousX = balloons.getPreviousX();
+    const std::vector<float>& previousY = balloons.getPreviousY();
+    const std::vector<uint32_t>& spawnOrder = balloons.getSpawnOrder();
+
+    // Swap-and-pop only disturbs the pool order where balloons were removed,
+    // so this sorts an almost sorted range
+    ArenaVector<uint32_t> order(balloonCount, 0, ArenaAllocator<uint32_t>(arena));
+    for (size_t i = 0; i < balloonCount; ++i) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return spawnOrder[a] < spawnOrder[b]; });
+
+    balloonPosition.resize(balloonCount);
+    balloonPreviousPosition.resize(balloonCount);
+    balloonSize.resize(balloonCount);
+    balloonColor.resize(balloonCount);
+    for (size_t i = 0; i < balloonCount; ++i) {
+        size_t index = order[i];
+        balloonPosition[i] = glm::vec2(x[index], y[index]);
+        balloonPreviousPosition[i] = glm::vec2(previousX[index], previousY[index]);
+        balloonSize[i] = balloons.getSize()[index];
+        balloonColor[i] = balloons.getColor()[index];
+    }
+
+    const size_t fragmentCount = fragments.size();
+    fragmentPosition.resize(fragmentCount);
+    fragmentPreviousPosition.resize(fragmentCount);
+    fragmentColor.resize(fragmentCount);
+    fragmentSize.resize(fragmentCount);
+    for (size_t i = 0; i < fragmentCount; ++i) {
+        fragmentPosition[i] = fragments.getPosition(i);
+        fragmentPreviousPosition[i] = fragments.getPreviousPosition(i);
+        fragmentColor[i] = fragments.getColor(i);
+        fragmentSize[i] = fragments.getSize(i);
+    }
+}
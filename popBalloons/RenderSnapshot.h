@@ -0,0 +1,47 @@
+#ifndef RENDER_SNAPSHOT_H
+#define RENDER_SNAPSHOT_H
+
+#include <glm/glm.hpp>
+#include <cstdint>
+#include "FrameArena.h"
+
+class BalloonPool;
+class ParticleSystem;
+
+// Everything the renderer needs from one simulation step, copied out of the
+// live game state so the simulation can keep going while it is drawn.
+// Previous positions are carried along so frames can interpolate between steps.
+// Balloons are stored in spawn order, earliest first, whatever their pool indices,
+// so the renderer can place them in depth by their position in these arrays.
+//
+// The arrays live in the snapshot's own FrameArena, which capture() resets:
+// a snapshot's data lasts exactly until its mailbox slot is refilled.
+struct RenderSnapshot {
+    RenderSnapshot();
+
+    RenderSnapshot(const RenderSnapshot&) = delete;
+    RenderSnapshot& operator=(const RenderSnapshot&) = delete;
+
+    FrameArena arena; // Declared first: every array below allocates from it
+
+    ArenaVector<glm::vec2> balloonPosition;
+    ArenaVector<glm::vec2> balloonPreviousPosition;
+    ArenaVector<float> balloonSize;
+    ArenaVector<glm::vec3> balloonColor;
+
+    ArenaVector<glm::vec3> fragmentPosition;
+    ArenaVector<glm::vec3> fragmentPreviousPosition;
+    ArenaVector<glm::vec4> fragmentColor;
+    ArenaVector<float> fragmentSize;
+
+    double stateTime = 0.0; // Clock time the latest step stands for; frames interpolate from here
+    uint64_t tick = 0;      // Steps simulated so far
+    int score = 0;
+    int lives = 0;
+    bool gameOver = false;
+
+    // Resets the arena and refills every array from it
+    void capture(const BalloonPool& balloons, const ParticleSystem& fragments);
+};
+
+#endif // RENDER_SNAPSHOT_H
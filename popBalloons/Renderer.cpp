@@ -1,13 +1,30 @@
 #include "Renderer.h"
-#include <common/shader.hpp>
+#include <array>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/matrix_transform.hpp> 
-#include <iostream>
-
-
-
-Renderer::Renderer() {
-    
+#include "Log.h"
+#include "CircleLod.h"
+
+
+
+Renderer::Renderer()
+    : frameTime(0.0),
+      frameUniformBuffer(0),
+      balloonShader(ShaderRegistry::kInvalidHandle),
+      balloonVAO(0),
+      balloonVBO(0),
+      viewportHeight(0),
+      balloonShading(BalloonShading::Mesh),
+      sdfBalloonShader(ShaderRegistry::kInvalidHandle),
+      sdfBalloonVAO(0),
+      particleShader(ShaderRegistry::kInvalidHandle),
+      fragmentVAO(0),
+      particleBackend(ParticleBackend::Cpu),
+      gpuParticleShader(ShaderRegistry::kInvalidHandle),
+      analyticParticleShader(ShaderRegistry::kInvalidHandle)
+{
+    frameUniforms.MVP = glm::mat4(1.0f);
+    frameUniforms.time = 0.0f;
 }
 
 Renderer::~Renderer() {
@@ -15,22 +32,41 @@ Renderer::~Renderer() {
 }
 
 void Renderer::initialize() {
-    // Create and compile the GLSL program from the shaders
-    balloonProgramID = LoadShaders("SimpleVertexShader.vertexshader", "SimpleFragmentShader.fragmentshader");
+    // Per-frame data lives in one uniform buffer that every program reads through its FrameData block
+    glGenBuffers(1, &frameUniformBuffer);
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+    glBufferData(GL_UNIFORM_BUFFER, sizeof(FrameUniforms), &frameUniforms, GL_DYNAMIC_DRAW);
+    glBindBufferBase(GL_UNIFORM_BUFFER, kFrameDataBinding, frameUniformBuffer);
+    shaders.bindUniformBlock("FrameData", kFrameDataBinding);
+
+    // Create and compile the GLSL programs from the shaders; edits on disk are picked up while running
+    balloonShader = shaders.load("BalloonVertexShader.vertexshader", "SimpleFragmentShader.fragmentshader");
+    particleShader = shaders.load("SimpleVertexShader.vertexshader", "FragmentParticle.fragmentshader");
+    if (shaders.program(balloonShader) == 0 || shaders.program(particleShader) == 0) {
+        LOG_ERROR("Shader compilation failed; run from the popBalloons directory so the shaders are found");
+    }
 
-    // Balloon VAO and VBO setup
+    // Balloon VAO setup: shared unit-circle meshes plus one instance record per balloon
     glGenVertexArrays(1, &balloonVAO);
     glBindVertexArray(balloonVAO);
 
+    // The circles never change, so upload every level of detail once and scale them per instance in the shader
     glGenBuffers(1, &balloonVBO);
     glBindBuffer(GL_ARRAY_BUFFER, balloonVBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(CircleLod::kFans), CircleLod::kFans.data(), GL_STATIC_DRAW);
+
+    glEnableVertexAttribArray(0); // for unit-circle positions
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, sizeof(CircleLod::Vertex), (void*)0);
 
-    // Define the vertex data layout for balloons
-    glEnableVertexAttribArray(0); 
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+    // Per-instance attributes; their pointers are set each frame to the stream region being drawn
+    balloonInstanceStream.initialize(1024 * sizeof(BalloonInstanceData));
 
-    glEnableVertexAttribArray(1); // for vertex colors
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(offsetof(Vertex, r)));
+    glEnableVertexAttribArray(1); // for balloon centres
+    glVertexAttribDivisor(1, 1);
+    glEnableVertexAttribArray(2); // for balloon radii
+    glVertexAttribDivisor(2, 1);
+    glEnableVertexAttribArray(3); // for balloon colors
+    glVertexAttribDivisor(3, 1);
 
     glBindVertexArray(0); // Unbind the VAO
 
@@ -38,18 +74,11 @@ void Renderer::initialize() {
     glGenVertexArrays(1, &fragmentVAO);
     glBindVertexArray(fragmentVAO);
 
-    glGenBuffers(1, &fragmentVBO);
-    glBindBuffer(GL_ARRAY_BUFFER, fragmentVBO);
+    fragmentStream.initialize(4096 * sizeof(FragmentVertexData));
 
-    // Define the vertex data layout for fragment particles
     glEnableVertexAttribArray(0); // for fragment positions
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(FragmentVertexData), (void*)0);
-
     glEnableVertexAttribArray(1); // for fragment colors
-    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(FragmentVertexData), (void*)(offsetof(FragmentVertexData, color)));
-
     glEnableVertexAttribArray(2); // Enable the attribute location for size
-    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(FragmentVertexData), (void*)(offsetof(FragmentVertexData, size)));
 
     glBindVertexArray(0); // Unbind the VAO
 
@@ -57,60 +86,220 @@ void Renderer::initialize() {
     glEnable(GL_PROGRAM_POINT_SIZE);
 }
 
+BalloonShading Renderer::setBalloonShading(BalloonShading shading) {
+    if (shading == BalloonShading::Sdf && !sdfBalloonVAO) {
+        sdfBalloonShader = shaders.load("BalloonSDF.vertexshader", "BalloonSDF.fragmentshader");
+        if (shaders.program(sdfBalloonShader) == 0) {
+            LOG_ERROR("SDF balloon shaders failed to build; drawing balloons as meshes");
+            return balloonShading;
+        }
+
+        // Reads the same instance records as the mesh path, with no per-vertex attributes
+        glGenVertexArrays(1, &sdfBalloonVAO);
+        glBindVertexArray(sdfBalloonVAO);
+        glEnableVertexAttribArray(1); // for balloon centres
+        glVertexAttribDivisor(1, 1);
+        glEnableVertexAttribArray(2); // for balloon radii
+        glVertexAttribDivisor(2, 1);
+        glEnableVertexAttribArray(3); // for balloon colors
+        glVertexAttribDivisor(3, 1);
+        glBindVertexArray(0);
+    }
+
+    balloonShading = shading;
+    return shading;
+}
+
+ParticleBackend Renderer::setParticleBackend(ParticleBackend backend) {
+    // Every backend draws with the CPU fragments' shaders, built with a define for its inputs
+    if (backend == ParticleBackend::TransformFeedback) {
+        gpuParticleShader = shaders.load("SimpleVertexShader.vertexshader", "FragmentParticle.fragmentshader",
+                                         "#define REMAINING_LIFETIME 1\n");
+        if (shaders.program(gpuParticleShader) == 0 || !gpuFragments.initialize(shaders)) {
+            LOG_ERROR("GPU particles are unavailable; simulating fragments on the CPU");
+            gpuFragments.cleanup();
+            backend = ParticleBackend::Cpu;
+        }
+    } else if (backend == ParticleBackend::Analytic) {
+        analyticParticleShader = shaders.load("SimpleVertexShader.vertexshader", "FragmentParticle.fragmentshader",
+                                              "#define ANALYTIC 1\n");
+        if (shaders.program(analyticParticleShader) == 0) {
+            LOG_ERROR("Analytic particle shader failed to build; simulating fragments on the CPU");
+            backend = ParticleBackend::Cpu;
+        } else {
+            analyticFragments.initialize();
+        }
+    }
+
+    particleBackend = backend;
+    return backend;
+}
+
+void Renderer::emitParticle(const GpuParticle& particle, double spawnTime) {
+    if (particleBackend == ParticleBackend::TransformFeedback) {
+        gpuFragments.emit(particle, spawnTime);
+    } else if (particleBackend == ParticleBackend::Analytic) {
+        // Spawn and death times are set relative to the epoch once the particle is flushed
+        AnalyticParticle analytic = { particle.position, particle.velocity, particle.color, particle.size, 0.0f, 0.0f };
+        analyticFragments.emit(analytic, spawnTime, particle.lifetime);
+    }
+}
+
+void Renderer::updateParticles(float deltaTime, double currentTime) {
+    if (particleBackend == ParticleBackend::TransformFeedback) {
+        gpuFragments.update(deltaTime, currentTime);
+    } else if (particleBackend == ParticleBackend::Analytic) {
+        analyticFragments.flush();
+        setTime(frameTime); // The flush may have moved the epoch
+    }
+}
+
+void Renderer::setTime(double seconds) {
+    frameTime = seconds;
+    frameUniforms.time = static_cast<float>(seconds - analyticFragments.getEpoch());
+    uploadFrameUniforms();
+}
+
 void Renderer::setProjectionMatrix(const glm::mat4& proj) {
-    projectionMatrix = proj;
+    frameUniforms.MVP = proj;
+    uploadFrameUniforms();
+}
 
-   
-    glUseProgram(balloonProgramID); 
-    GLuint matrixID = glGetUniformLocation(balloonProgramID, "MVP"); 
-    glUniformMatrix4fv(matrixID, 1, GL_FALSE, glm::value_ptr(projectionMatrix));
+void Renderer::uploadFrameUniforms() {
+    glBindBuffer(GL_UNIFORM_BUFFER, frameUniformBuffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(FrameUniforms), &frameUniforms);
 }
 
-void Renderer::render(const std::vector<Balloon>& balloons, const std::vector<Fragment>& fragments) {
- 
-    glUseProgram(balloonProgramID); // Use the shader program
-    glBindVertexArray(balloonVAO);
-    for (const Balloon& balloon : balloons) {
-        std::vector<Vertex> vertices = createBalloonVertices(balloon);
-        
-        glBindBuffer(GL_ARRAY_BUFFER, balloonVBO);
-        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), vertices.data(), GL_STATIC_DRAW);
-        glDrawArrays(GL_TRIANGLE_FAN, 0, vertices.size());
+void Renderer::render(const RenderSnapshot& snapshot, float alpha) {
+    // Pick up shader edits made while the game is running
+    shaders.pollChanges();
+
+    if (!snapshot.balloonPosition.empty()) {
+        // Write one instance record per balloon straight into GPU-visible memory, then draw them all at once
+        const size_t count = snapshot.balloonPosition.size();
+
+        // Mesh balloons are grouped by level of detail, one instanced draw per group; each instance's
+        // depth comes from its place in the snapshot's spawn order, so the groups can be drawn in any order.
+        // The projection maps a world unit to MVP[1][1] half-heights of the viewport.
+        const bool grouped = balloonShading == BalloonShading::Mesh;
+        const float pixelsPerUnit = frameUniforms.MVP[1][1] * 0.5f * static_cast<float>(viewportHeight);
+        std::array<size_t, CircleLod::kLevelCount> groupCount{};
+        std::array<size_t, CircleLod::kLevelCount> groupEnd{}; // Next free slot in each group while writing
+        if (grouped) {
+            for (size_t i = 0; i < count; ++i) {
+                ++groupCount[CircleLod::levelFor(snapshot.balloonSize[i] * pixelsPerUnit)];
+            }
+            for (size_t level = 1; level < CircleLod::kLevelCount; ++level) {
+                groupEnd[level] = groupEnd[level - 1] + groupCount[level - 1];
+            }
+        }
+
+        BalloonInstanceData* instances = static_cast<BalloonInstanceData*>(balloonInstanceStream.map(count * sizeof(BalloonInstanceData)));
+        if (instances) {
+            for (size_t i = 0; i < count; ++i) {
+                // SDF quads blend their edges over whatever was drawn before them, so write them back to
+                // front: the earliest spawned then lands on top, as HitPick::Topmost expects
+                size_t slot = grouped ? groupEnd[CircleLod::levelFor(snapshot.balloonSize[i] * pixelsPerUnit)]++ : count - 1 - i;
+                glm::vec2 position = glm::mix(snapshot.balloonPreviousPosition[i], snapshot.balloonPosition[i], alpha);
+                instances[slot] = BalloonInstanceData(glm::vec3(position, balloonDepth(i, count)), snapshot.balloonSize[i], glm::vec4(snapshot.balloonColor[i], 1.0f));
+            }
+            GLintptr offset = balloonInstanceStream.unmap();
+
+            if (balloonShading == BalloonShading::Sdf) {
+                // The fragment shader discards the quad corners outside the circle, so only covered
+                // pixels write depth: fragments behind a balloon stay hidden as they do with meshes,
+                // while a neighbouring balloon still shows through the corners. The edge is blended in.
+                glUseProgram(shaders.program(sdfBalloonShader));
+                glBindVertexArray(sdfBalloonVAO);
+                bindBalloonInstances(offset);
+                glEnable(GL_BLEND);
+                glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+                glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(count));
+                glDisable(GL_BLEND);
+            } else {
+                glUseProgram(shaders.program(balloonShader)); // Use the shader program
+                glBindVertexArray(balloonVAO);
+                for (size_t level = 0; level < CircleLod::kLevelCount; ++level) {
+                    if (groupCount[level] == 0) {
+                        continue;
+                    }
+                    size_t first = groupEnd[level] - groupCount[level];
+                    bindBalloonInstances(offset + static_cast<GLintptr>(first * sizeof(BalloonInstanceData)));
+                    glDrawArraysInstanced(GL_TRIANGLE_FAN, static_cast<GLint>(CircleLod::firstVertex(level)),
+                                          static_cast<GLsizei>(CircleLod::vertexCount(level)), static_cast<GLsizei>(groupCount[level]));
+                }
+            }
+            balloonInstanceStream.fence();
+        }
     }
-    
 
-    if (!fragments.empty()) {
-        glBindVertexArray(fragmentVAO);
-        std::vector<FragmentVertexData> fragmentVertices;
-        for (const Fragment& fragment : fragments) {
-            fragmentVertices.emplace_back(FragmentVertexData{fragment.position, fragment.color, fragment.size});
+    if (particleBackend == ParticleBackend::TransformFeedback) {
+        // Particle state never leaves the GPU; the update already ran this frame
+        glUseProgram(shaders.program(gpuParticleShader));
+        gpuFragments.draw();
+    } else if (particleBackend == ParticleBackend::Analytic) {
+        // Nothing to upload: the shader places every fragment from FrameData.time
+        glUseProgram(shaders.program(analyticParticleShader));
+        analyticFragments.draw(frameTime);
+    } else if (!snapshot.fragmentPosition.empty()) {
+        const size_t count = snapshot.fragmentPosition.size();
+
+        FragmentVertexData* vertices = static_cast<FragmentVertexData*>(fragmentStream.map(count * sizeof(FragmentVertexData)));
+        if (vertices) {
+            for (size_t i = 0; i < count; ++i) {
+                glm::vec3 position = glm::mix(snapshot.fragmentPreviousPosition[i], snapshot.fragmentPosition[i], alpha);
+                vertices[i] = FragmentVertexData(position, snapshot.fragmentColor[i], snapshot.fragmentSize[i]);
+            }
+            GLintptr offset = fragmentStream.unmap();
+
+            glUseProgram(shaders.program(particleShader));
+            glBindVertexArray(fragmentVAO);
+            // The lifetime attribute is not streamed; one second past the current time keeps every fragment fully opaque
+            glVertexAttrib1f(3, frameUniforms.time + 1.0f);
+            bindFragmentVertices(offset);
+            glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(count));
+            fragmentStream.fence();
         }
-        
-        glBindBuffer(GL_ARRAY_BUFFER, fragmentVBO);
-        glBufferData(GL_ARRAY_BUFFER, fragmentVertices.size() * sizeof(FragmentVertexData), fragmentVertices.data(), GL_DYNAMIC_DRAW);
-        glDrawArrays(GL_POINTS, 0, fragmentVertices.size());
     }
 
     // Unbind VAO to be safe
     glBindVertexArray(0);
 }
+
+float Renderer::balloonDepth(size_t index, size_t count) {
+    // The orthographic projection maps z = 1 to the near plane and z = -1 to the far one
+    return static_cast<float>(count - index) / static_cast<float>(count + 1);
+}
+
+// Points the balloon instance attributes at the stream region written this frame
+void Renderer::bindBalloonInstances(GLintptr offset) {
+    glBindBuffer(GL_ARRAY_BUFFER, balloonInstanceStream.getBuffer());
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(BalloonInstanceData), (void*)(offset + offsetof(BalloonInstanceData, position)));
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(BalloonInstanceData), (void*)(offset + offsetof(BalloonInstanceData, size)));
+    glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(BalloonInstanceData), (void*)(offset + offsetof(BalloonInstanceData, color)));
+}
+
+// Points the fragment vertex attributes at the stream region written this frame
+void Renderer::bindFragmentVertices(GLintptr offset) {
+    glBindBuffer(GL_ARRAY_BUFFER, fragmentStream.getBuffer());
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(FragmentVertexData), (void*)(offset + offsetof(FragmentVertexData, position)));
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, sizeof(FragmentVertexData), (void*)(offset + offsetof(FragmentVertexData, color)));
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, sizeof(FragmentVertexData), (void*)(offset + offsetof(FragmentVertexData, size)));
+}
+
 void Renderer::resize(int width, int height) {
     if (width == 0 || height == 0) {
-        std::cout << "Resize was called with a zero width or height, ignoring." << std::endl;
+        LOG_DEBUG("Resize was called with a zero width or height, ignoring.");
         return;
     }
 
     glViewport(0, 0, width, height);
+    viewportHeight = height;
 
     float aspectRatio = static_cast<float>(width) / static_cast<float>(height);
-    glm::mat4 projection = glm::ortho(-aspectRatio, aspectRatio, -1.0f, 1.0f);
-
-
-    glUseProgram(balloonProgramID);
-    GLuint matrixID = glGetUniformLocation(balloonProgramID, "MVP");
-    glUniformMatrix4fv(matrixID, 1, GL_FALSE, glm::value_ptr(projection));
+    setProjectionMatrix(glm::ortho(-aspectRatio, aspectRatio, -1.0f, 1.0f));
 
-    std::cout << "Framebuffer size after resize: " << width << "x" << height << std::endl;
+    LOG_INFO("Framebuffer size after resize: %dx%d", width, height);
 }
 
 void Renderer::cleanup() {
@@ -122,40 +311,39 @@ void Renderer::cleanup() {
         glDeleteBuffers(1, &balloonVBO);
         balloonVBO = 0;
     }
+    if (sdfBalloonVAO) {
+        glDeleteVertexArrays(1, &sdfBalloonVAO);
+        sdfBalloonVAO = 0;
+    }
+    balloonInstanceStream.cleanup();
     if (fragmentVAO) {
         glDeleteVertexArrays(1, &fragmentVAO);
         fragmentVAO = 0;
     }
-    if (fragmentVBO) {
-        glDeleteBuffers(1, &fragmentVBO);
-        fragmentVBO = 0;
-    }
-   
-    if (balloonProgramID) {
-        glDeleteProgram(balloonProgramID);
-        balloonProgramID = 0;
+    fragmentStream.cleanup();
+    gpuFragments.cleanup();
+    analyticFragments.cleanup();
+
+    shaders.cleanup();
+    balloonShader = sdfBalloonShader = particleShader = ShaderRegistry::kInvalidHandle;
+    gpuParticleShader = analyticParticleShader = ShaderRegistry::kInvalidHandle;
+    if (frameUniformBuffer) {
+        glDeleteBuffers(1, &frameUniformBuffer);
+        frameUniformBuffer = 0;
     }
 }
-std::vector<Vertex> Renderer::createBalloonVertices(const Balloon& balloon) {
-    std::vector<Vertex> vertices;
-    glm::vec3 position = balloon.getPosition(); // Balloon position
-    glm::vec3 color = balloon.getColor(); // Balloon color
-    float alphaValue = 1.0f; 
-    float radius = balloon.getSize(); // set the radius
-    unsigned int num_segments = 20;  // decide the number of segments you want to divide your balloon into
-
+// Builds a triangle fan around the origin with radius 1 at any segment count.
+// The renderer draws the precomputed CircleLod fans instead, which match this at their segment counts.
+std::vector<glm::vec2> Renderer::createUnitCircleVertices(unsigned int numSegments) {
+    std::vector<glm::vec2> vertices;
+    vertices.reserve(numSegments + 2);
 
-    vertices.emplace_back(Vertex{position.x, position.y, color.r, color.g, color.b, alphaValue});
+    vertices.emplace_back(0.0f, 0.0f); // Fan centre
 
-
-    for (unsigned int i = 0; i <= num_segments; ++i) { 
-        float theta = 2.0f * glm::pi<float>() * float(i) / float(num_segments);
-        float px = position.x + radius * cosf(theta); // compute x coordinate
-        float py = position.y + radius * sinf(theta); // compute y coordinate
-
-        vertices.emplace_back(Vertex{px, py, color.r, color.g, color.b, alphaValue});
+    for (unsigned int i = 0; i <= numSegments; ++i) { 
+        float theta = 2.0f * glm::pi<float>() * float(i) / float(numSegments);
+        vertices.emplace_back(cosf(theta), sinf(theta));
     }
 
-
     return vertices;
 }
\ No newline at end of file
@@ -5,11 +5,26 @@
 #include <glfw3.h>
 #include <glm/glm.hpp>
 #include <vector>
-#include "Balloon.h" 
-#include "Vertex.h"  
-#include "Fragment.h"
+#include "RenderSnapshot.h"
+#include "StreamBuffer.h"
+#include "ShaderRegistry.h"
+#include "GpuParticleSystem.h"
+#include "AnalyticParticleSystem.h"
 
 
+// Where explosion fragments are simulated
+enum class ParticleBackend {
+    Cpu,               // ParticleSystem in the simulation, streamed from each snapshot
+    TransformFeedback, // GpuParticleSystem, stepped on the GPU every frame
+    Analytic           // AnalyticParticleSystem, evaluated in closed form by the vertex shader
+};
+
+// How balloons are drawn
+enum class BalloonShading {
+    Mesh, // Shared triangle-fan circle, edges as smooth as its tessellation
+    Sdf   // One quad per balloon, circle shaded from its signed distance with an antialiased edge
+};
+
 struct FragmentVertexData {
     glm::vec3 position; // Position in space
     glm::vec4 color;    // RGBA color with alpha
@@ -18,15 +33,56 @@ struct FragmentVertexData {
     FragmentVertexData(const glm::vec3& pos, const glm::vec4& col, float s)
         : position(pos), color(col), size(s) {}
 };
+
+// Per-instance attributes for one balloon, read once per balloon by the instanced draw
+struct BalloonInstanceData {
+    glm::vec3 position; // Balloon centre
+    float size;         // Balloon radius
+    glm::vec4 color;    // RGBA color
+
+    BalloonInstanceData(const glm::vec3& pos, float s, const glm::vec4& col)
+        : position(pos), size(s), color(col) {}
+};
+
+// Per-frame shader inputs, laid out std140 to match the FrameData block in the shaders
+struct FrameUniforms {
+    glm::mat4 MVP;  // Model-View-Projection matrix
+    float time;     // Seconds since AnalyticParticleSystem's epoch, for animated shaders
+    float padding[3];
+};
+
 class Renderer {
 public:
     Renderer();
     ~Renderer();
 
-    std::vector<Vertex> createBalloonVertices(const Balloon& balloon);
+    static std::vector<glm::vec2> createUnitCircleVertices(unsigned int numSegments);
+    // World-space z for the balloon at this index in a RenderSnapshot, which lists balloons in
+    // spawn order: earlier spawns are nearer, so the depth test keeps the balloon HitPick::Topmost
+    // picks on top whatever order the instances are drawn in, and swap-and-pop cannot reorder them.
+    // Every value is in (0, 1), in front of the z = 0 plane that fragments spawn on.
+    static float balloonDepth(size_t index, size_t count);
     void initialize();
-    void render(const std::vector<Balloon>& balloons, const std::vector<Fragment>& fragments);
+    // alpha blends each position from before the last simulation step (0) to the latest one (1)
+    void render(const RenderSnapshot& snapshot, float alpha = 1.0f);
     void setProjectionMatrix(const glm::mat4& proj);
+
+    // Picks the balloon path; call after initialize. Returns the one actually in use,
+    // which is Mesh when the SDF shaders cannot be built.
+    BalloonShading setBalloonShading(BalloonShading shading);
+
+    // Seconds on the clock fragments are spawned against. Shaders read it as FrameData.time,
+    // counted from the analytic particles' epoch so the float keeps its precision.
+    void setTime(double seconds);
+
+    // Picks the fragment backend; call after initialize. Returns the backend actually in use,
+    // which is Cpu when the requested one cannot be set up. With a GPU backend snapshot
+    // fragments are ignored and particles come from emitParticle instead.
+    ParticleBackend setParticleBackend(ParticleBackend backend);
+    void emitParticle(const GpuParticle& particle, double spawnTime);
+    // Makes emitted particles visible and moves the GPU simulation on by deltaTime,
+    // to currentTime on the clock spawn times are given on
+    void updateParticles(float deltaTime, double currentTime);
     void resize(int width, int height);
     void cleanup();
 
@@ -34,16 +90,36 @@ public:
     //GLuint VAO, VBO;
 
 private:
-    
-    glm::mat4 projectionMatrix;
+    void bindBalloonInstances(GLintptr offset);
+    void bindFragmentVertices(GLintptr offset);
+    void uploadFrameUniforms();
 
-    GLuint balloonProgramID;
+    static const GLuint kFrameDataBinding = 0;
+
+    ShaderRegistry shaders;
+    FrameUniforms frameUniforms;
+    double frameTime;          // Last setTime; frameUniforms.time holds it relative to the particle epoch
+    GLuint frameUniformBuffer;
+
+    ShaderRegistry::Handle balloonShader;
     GLuint balloonVAO;
-    GLuint balloonVBO;
+    GLuint balloonVBO;         // Every CircleLod fan, uploaded once
+    StreamBuffer balloonInstanceStream; // Per-balloon BalloonInstanceData, rewritten every frame
+    int viewportHeight;        // Pixels, for picking each balloon's level of detail
 
-    
+    BalloonShading balloonShading;
+    ShaderRegistry::Handle sdfBalloonShader;
+    GLuint sdfBalloonVAO;      // Instance attributes only; quad corners come from gl_VertexID
+
+    ShaderRegistry::Handle particleShader;
     GLuint fragmentVAO;
-    GLuint fragmentVBO;
+    StreamBuffer fragmentStream; // Per-fragment FragmentVertexData, rewritten every frame
+
+    ParticleBackend particleBackend;
+    ShaderRegistry::Handle gpuParticleShader;
+    GpuParticleSystem gpuFragments;
+    ShaderRegistry::Handle analyticParticleShader;
+    AnalyticParticleSystem analyticFragments;
 };
 
 #endif
\ No newline at end of file
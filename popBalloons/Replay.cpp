@@ -0,0 +1,252 @@
+#include "Replay.h"
+#include "Game.h"
+#include "Log.h"
+#include <cstring>
+
+namespace {
+
+const char kMagic[4] = { 'P', 'B', 'R', 'P' };
+const uint32_t kVersion = 2; // 2 added the End event
+const size_t kFlushThreshold = 64 * 1024;
+
+} // namespace
+
+ReplayRecorder::ReplayRecorder()
+    : file(nullptr), ticks(0) {
+}
+
+ReplayRecorder::~ReplayRecorder() {
+    close();
+}
+
+bool ReplayRecorder::open(const char* path, uint32_t seed, int fbWidth, int fbHeight) {
+    close();
+
+    file = fopen(path, "wb");
+    if (!file) {
+        LOG_ERROR("Could not open replay file %s for writing", path);
+        return false;
+    }
+
+    ticks = 0;
+    put(kMagic, sizeof(kMagic));
+    putU32(kVersion);
+    putU32(seed);
+    putU32(static_cast<uint32_t>(fbWidth));
+    putU32(static_cast<uint32_t>(fbHeight));
+    return true;
+}
+
+void ReplayRecorder::close() {
+    if (!file) {
+        return;
+    }
+
+    flushBuffer();
+    fclose(file);
+    file = nullptr;
+}
+
+void ReplayRecorder::recordTick(float deltaTime) {
+    ReplayEvent type = ReplayEvent::Tick;
+    put(&type, sizeof(type));
+    putFloat(deltaTime);
+    ++ticks;
+}
+
+void ReplayRecorder::recordClick(float xpos, float ypos) {
+    ReplayEvent type = ReplayEvent::Click;
+    put(&type, sizeof(type));
+    putFloat(xpos);
+    putFloat(ypos);
+}
+
+void ReplayRecorder::recordResize(int width, int height) {
+    ReplayEvent type = ReplayEvent::Resize;
+    put(&type, sizeof(type));
+    putU32(static_cast<uint32_t>(width));
+    putU32(static_cast<uint32_t>(height));
+}
+
+void ReplayRecorder::recordEnd(uint64_t stateHash) {
+    ReplayEvent type = ReplayEvent::End;
+    put(&type, sizeof(type));
+    putU64(ticks);
+    putU64(stateHash);
+}
+
+void ReplayRecorder::put(const void* bytes, size_t count) {
+    if (!file) {
+        return;
+    }
+
+    const unsigned char* begin = static_cast<const unsigned char*>(bytes);
+    buffer.insert(buffer.end(), begin, begin + count);
+    if (buffer.size() >= kFlushThreshold) {
+        flushBuffer();
+    }
+}
+
+// Multi-byte fields are written a byte at a time so the file is little-endian on any host
+void ReplayRecorder::putU32(uint32_t value) {
+    unsigned char bytes[4];
+    for (size_t i = 0; i < sizeof(bytes); ++i) {
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+    put(bytes, sizeof(bytes));
+}
+
+void ReplayRecorder::putU64(uint64_t value) {
+    unsigned char bytes[8];
+    for (size_t i = 0; i < sizeof(bytes); ++i) {
+        bytes[i] = static_cast<unsigned char>(value >> (8 * i));
+    }
+    put(bytes, sizeof(bytes));
+}
+
+void ReplayRecorder::putFloat(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    putU32(bits);
+}
+
+void ReplayRecorder::flushBuffer() {
+    if (!buffer.empty()) {
+        fwrite(buffer.data(), 1, buffer.size(), file);
+        buffer.clear();
+    }
+}
+
+ReplayPlayer::ReplayPlayer()
+    : cursor(0), seed(0), fbWidth(0), fbHeight(0), ticks(0),
+      ended(false), recordedTicks(0), recordedStateHash(0) {
+}
+
+bool ReplayPlayer::open(const char* path) {
+    FILE* file = fopen(path, "rb");
+    if (!file) {
+        LOG_ERROR("Could not open replay file %s", path);
+        return false;
+    }
+
+    // Recordings are small (5 bytes per tick), so read the whole file up front
+    data.clear();
+    unsigned char chunk[64 * 1024];
+    size_t count;
+    while ((count = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+        data.insert(data.end(), chunk, chunk + count);
+    }
+    fclose(file);
+
+    cursor = 0;
+    ticks = 0;
+    ended = false;
+
+    char magic[4];
+    uint32_t version = 0;
+    int32_t width = 0, height = 0;
+    if (!readBytes(magic, sizeof(magic)) || memcmp(magic, kMagic, sizeof(kMagic)) != 0 ||
+        !readU32(version) || !readU32(seed) || !readI32(width) || !readI32(height)) {
+        LOG_ERROR("%s is not a popBalloons replay", path);
+        return false;
+    }
+    if (version != kVersion) {
+        LOG_ERROR("%s has replay version %u, expected %u", path, version, kVersion);
+        return false;
+    }
+
+    fbWidth = width;
+    fbHeight = height;
+    return true;
+}
+
+bool ReplayPlayer::step(Game& game) {
+    ReplayEvent type;
+    while (readBytes(&type, sizeof(type))) {
+        switch (type) {
+        case ReplayEvent::Tick: {
+            float deltaTime;
+            if (!readFloat(deltaTime)) {
+                return false;
+            }
+            game.update(deltaTime);
+            ++ticks;
+            return true;
+        }
+        case ReplayEvent::Click: {
+            float xpos, ypos;
+            if (!readFloat(xpos) || !readFloat(ypos)) {
+                return false;
+            }
+            game.handleClick(xpos, ypos);
+            break;
+        }
+        case ReplayEvent::Resize: {
+            int32_t width, height;
+            if (!readI32(width) || !readI32(height)) {
+                return false;
+            }
+            game.setFramebufferSize(width, height);
+            break;
+        }
+        case ReplayEvent::End:
+            ended = readU64(recordedTicks) && readU64(recordedStateHash);
+            return false;
+        default:
+            LOG_ERROR("Unknown replay event %d at byte %zu", static_cast<int>(type), cursor - 1);
+            return false;
+        }
+    }
+    return false;
+}
+
+bool ReplayPlayer::readBytes(void* bytes, size_t count) {
+    if (data.size() - cursor < count) {
+        return false;
+    }
+    memcpy(bytes, data.data() + cursor, count);
+    cursor += count;
+    return true;
+}
+
+bool ReplayPlayer::readU32(uint32_t& value) {
+    unsigned char bytes[4];
+    if (!readBytes(bytes, sizeof(bytes))) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < sizeof(bytes); ++i) {
+        value |= static_cast<uint32_t>(bytes[i]) << (8 * i);
+    }
+    return true;
+}
+
+bool ReplayPlayer::readU64(uint64_t& value) {
+    unsigned char bytes[8];
+    if (!readBytes(bytes, sizeof(bytes))) {
+        return false;
+    }
+    value = 0;
+    for (size_t i = 0; i < sizeof(bytes); ++i) {
+        value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    }
+    return true;
+}
+
+bool ReplayPlayer::readI32(int32_t& value) {
+    uint32_t bits;
+    if (!readU32(bits)) {
+        return false;
+    }
+    value = static_cast<int32_t>(bits);
+    return true;
+}
+
+bool ReplayPlayer::readFloat(float& value) {
+    uint32_t bits;
+    if (!readU32(bits)) {
+        return false;
+    }
+    memcpy(&value, &bits, sizeof(value));
+    return true;
+}
@@ -0,0 +1,91 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+class Game;
+
+// Compact binary log of everything that feeds the simulation, so a session can
+// be re-run headlessly and bit-exactly as a benchmark or regression check.
+//
+// Layout (every field little-endian, floats as their IEEE 754 bits):
+//   header  "PBRP", uint32 version, uint32 seed, int32 fbWidth, int32 fbHeight
+//   events  uint8 type followed by its payload, in the order Game applied them
+//     Tick    float deltaTime         (one Game::update)
+//     Click   float xpos, float ypos  (framebuffer pixels, as passed to Game::handleClick)
+//     Resize  int32 width, int32 height
+//     End     uint64 ticks, uint64 stateHash (written once when recording stops)
+// The End event lets a replay check that it reproduced the session bit-exactly.
+enum class ReplayEvent : uint8_t {
+    Tick = 1,
+    Click = 2,
+    Resize = 3,
+    End = 4
+};
+
+class ReplayRecorder {
+public:
+    ReplayRecorder();
+    ~ReplayRecorder();
+
+    bool open(const char* path, uint32_t seed, int fbWidth, int fbHeight);
+    void close();
+    bool isOpen() const { return file != nullptr; }
+
+    void recordTick(float deltaTime);
+    void recordClick(float xpos, float ypos);
+    void recordResize(int width, int height);
+    // Stores Game::stateHash() after the last event; call once, right before close()
+    void recordEnd(uint64_t stateHash);
+
+private:
+    void put(const void* bytes, size_t count);
+    void putU32(uint32_t value);
+    void putU64(uint64_t value);
+    void putFloat(float value);
+    void flushBuffer();
+
+    FILE* file;
+    uint64_t ticks; // Tick events written so far
+    std::vector<unsigned char> buffer; // Batches writes so a tick costs a memcpy, not a syscall
+};
+
+class ReplayPlayer {
+public:
+    ReplayPlayer();
+
+    bool open(const char* path);
+
+    uint32_t getSeed() const { return seed; }
+    int getFramebufferWidth() const { return fbWidth; }
+    int getFramebufferHeight() const { return fbHeight; }
+    uint64_t getTicks() const { return ticks; }
+
+    // Applies events up to and including the next tick; false once the recording is exhausted
+    bool step(Game& game);
+
+    // Whether the recording ended with an End event, and what it expects the replay to reach
+    bool hasEnd() const { return ended; }
+    uint64_t getRecordedTicks() const { return recordedTicks; }
+    uint64_t getRecordedStateHash() const { return recordedStateHash; }
+
+private:
+    bool readBytes(void* bytes, size_t count);
+    bool readU32(uint32_t& value);
+    bool readU64(uint64_t& value);
+    bool readI32(int32_t& value);
+    bool readFloat(float& value);
+
+    std::vector<unsigned char> data;
+    size_t cursor;
+    uint32_t seed;
+    int fbWidth, fbHeight;
+    uint64_t ticks;
+    bool ended;
+    uint64_t recordedTicks;
+    uint64_t recordedStateHash;
+};
+
+#endif // REPLAY_H
@@ -0,0 +1,188 @@
+#include "ShaderRegistry.h"
+#include <common/shader.hpp>
+#include "Log.h"
+
+ShaderRegistry::ShaderRegistry()
+    : checkInterval(0.25),
+      lastCheck(std::chrono::steady_clock::now())
+{
+}
+
+ShaderRegistry::~ShaderRegistry() {
+    cleanup();
+}
+
+void ShaderRegistry::bindUniformBlock(const char* blockName, GLuint bindingPoint) {
+    uniformBlocks.emplace_back(blockName, bindingPoint);
+
+    // Programs loaded earlier pick the block up too
+    for (Program& program : programs) {
+        if (program.id) {
+            introspect(program);
+        }
+    }
+}
+
+ShaderRegistry::Handle ShaderRegistry::load(const char* vertexPath, const char* fragmentPath, const char* defines) {
+    Program program;
+    program.id = 0;
+    program.vertexPath = vertexPath;
+    program.fragmentPath = fragmentPath;
+    program.vertexFile = program.vertexPath;
+    program.fragmentFile = program.fragmentPath;
+    program.defines = defines ? defines : "";
+    return add(program);
+}
+
+ShaderRegistry::Handle ShaderRegistry::loadTransformFeedback(const char* vertexPath, const char* const* varyings,
+                                                             int varyingCount, const char* defines) {
+    Program program;
+    program.id = 0;
+    program.vertexPath = vertexPath;
+    program.vertexFile = program.vertexPath;
+    program.defines = defines ? defines : "";
+    program.varyings.assign(varyings, varyings + varyingCount);
+    return add(program);
+}
+
+ShaderRegistry::Handle ShaderRegistry::add(Program& program) {
+    if (!build(program)) {
+        LOG_ERROR("Could not build %s %s; waiting for them to change",
+                  program.vertexPath.c_str(), program.fragmentPath.c_str());
+    }
+
+    programs.push_back(std::move(program));
+    return programs.size() - 1;
+}
+
+GLint ShaderRegistry::uniformLocation(Handle handle, const std::string& name) const {
+    if (handle >= programs.size()) {
+        return -1;
+    }
+    const std::unordered_map<std::string, GLint>& uniforms = programs[handle].uniforms;
+    auto it = uniforms.find(name);
+    return it != uniforms.end() ? it->second : -1;
+}
+
+GLint ShaderRegistry::attributeLocation(Handle handle, const std::string& name) const {
+    if (handle >= programs.size()) {
+        return -1;
+    }
+    const std::unordered_map<std::string, GLint>& attributes = programs[handle].attributes;
+    auto it = attributes.find(name);
+    return it != attributes.end() ? it->second : -1;
+}
+
+size_t ShaderRegistry::pollChanges() {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    if (std::chrono::duration<double>(now - lastCheck).count() < checkInterval) {
+        return 0;
+    }
+    lastCheck = now;
+
+    size_t replaced = 0;
+    for (Program& program : programs) {
+        if (modifiedTime(program.vertexFile) == program.vertexTime &&
+            modifiedTime(program.fragmentFile) == program.fragmentTime) {
+            continue;
+        }
+
+        LOG_INFO("Reloading %s %s", program.vertexPath.c_str(), program.fragmentPath.c_str());
+        if (build(program)) {
+            ++replaced;
+        } else {
+            LOG_ERROR("Reload of %s %s failed; keeping the previous program",
+                      program.vertexPath.c_str(), program.fragmentPath.c_str());
+        }
+    }
+    return replaced;
+}
+
+void ShaderRegistry::cleanup() {
+    for (Program& program : programs) {
+        if (program.id) {
+            glDeleteProgram(program.id);
+        }
+    }
+    programs.clear();
+}
+
+// Timestamps are taken before compiling, so an edit saved mid-build still triggers another reload
+bool ShaderRegistry::build(Program& program) {
+    program.vertexTime = modifiedTime(program.vertexFile);
+    program.fragmentTime = modifiedTime(program.fragmentFile);
+
+    const char* defines = program.defines.empty() ? nullptr : program.defines.c_str();
+    GLuint id;
+    if (program.varyings.empty()) {
+        id = LoadShaders(program.vertexPath.c_str(), program.fragmentPath.c_str(), defines);
+    } else {
+        std::vector<const char*> varyings;
+        for (const std::string& varying : program.varyings) {
+            varyings.push_back(varying.c_str());
+        }
+        id = LoadTransformFeedbackShader(program.vertexPath.c_str(), varyings.data(),
+                                         static_cast<int>(varyings.size()), defines);
+    }
+    if (id == 0) {
+        return false;
+    }
+
+    if (program.id) {
+        glDeleteProgram(program.id);
+    }
+    program.id = id;
+    introspect(program);
+    return true;
+}
+
+// Runs once per link: everything draw code needs by name is resolved here
+void ShaderRegistry::introspect(Program& program) {
+    program.uniforms.clear();
+    program.attributes.clear();
+
+    GLint count = 0;
+    GLint maxLength = 0;
+    std::vector<GLchar> name;
+
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORMS, &count);
+    glGetProgramiv(program.id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+    name.resize(maxLength + 1);
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveUniform(program.id, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+        std::string uniformName(name.data(), length);
+        // Members of uniform blocks have no location and are reached through the block instead
+        GLint location = glGetUniformLocation(program.id, uniformName.c_str());
+        if (location >= 0) {
+            program.uniforms[uniformName] = location;
+        }
+    }
+
+    glGetProgramiv(program.id, GL_ACTIVE_ATTRIBUTES, &count);
+    glGetProgramiv(program.id, GL_ACTIVE_ATTRIBUTE_MAX_LENGTH, &maxLength);
+    name.resize(maxLength + 1);
+    for (GLint i = 0; i < count; ++i) {
+        GLsizei length = 0;
+        GLint size = 0;
+        GLenum type = 0;
+        glGetActiveAttrib(program.id, static_cast<GLuint>(i), static_cast<GLsizei>(name.size()), &length, &size, &type, name.data());
+        std::string attributeName(name.data(), length);
+        program.attributes[attributeName] = glGetAttribLocation(program.id, attributeName.c_str());
+    }
+
+    for (const auto& block : uniformBlocks) {
+        GLuint index = glGetUniformBlockIndex(program.id, block.first.c_str());
+        if (index != GL_INVALID_INDEX) {
+            glUniformBlockBinding(program.id, index, block.second);
+        }
+    }
+}
+
+std::filesystem::file_time_type ShaderRegistry::modifiedTime(const std::filesystem::path& path) {
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(path, error);
+    return error ? std::filesystem::file_time_type::min() : time;
+}
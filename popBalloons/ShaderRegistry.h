@@ -0,0 +1,70 @@
+#ifndef SHADER_REGISTRY_H
+#define SHADER_REGISTRY_H
+
+#include <GL/glew.h>
+#include <chrono>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Owns every shader program the renderer uses.
+// After each link the active uniform and attribute locations are read once into
+// tables, and named uniform blocks are attached to their binding points, so draw
+// code never asks GL for a name. pollChanges() relinks any program whose source
+// files were modified on disk; a program that fails to rebuild keeps running
+// the last good version.
+class ShaderRegistry {
+public:
+    typedef size_t Handle;
+    static const Handle kInvalidHandle = static_cast<Handle>(-1); // Never returned by load; program() is 0 for it
+
+    ShaderRegistry();
+    ~ShaderRegistry();
+
+    // Uniform blocks with this name are bound to bindingPoint in every program, now and after reloads
+    void bindUniformBlock(const char* blockName, GLuint bindingPoint);
+
+    // Returns a handle even if the first build fails; program() is then 0 until the files are fixed
+    Handle load(const char* vertexPath, const char* fragmentPath, const char* defines = nullptr);
+    // A vertex-only program whose named outputs are captured by transform feedback, reloaded like the others
+    Handle loadTransformFeedback(const char* vertexPath, const char* const* varyings, int varyingCount,
+                                 const char* defines = nullptr);
+
+    GLuint program(Handle handle) const { return handle < programs.size() ? programs[handle].id : 0; }
+    GLint uniformLocation(Handle handle, const std::string& name) const;
+    GLint attributeLocation(Handle handle, const std::string& name) const;
+
+    // Checks file timestamps at most every checkInterval; returns how many programs were replaced
+    size_t pollChanges();
+    void setCheckInterval(double seconds) { checkInterval = seconds; }
+
+    void cleanup();
+
+private:
+    struct Program {
+        GLuint id;
+        std::string vertexPath;
+        std::string fragmentPath; // Empty for a transform feedback program
+        std::filesystem::path vertexFile;   // vertexPath and fragmentPath as filesystem paths, built once
+        std::filesystem::path fragmentFile; // so polling the timestamps does not allocate
+        std::string defines;
+        std::vector<std::string> varyings; // Transform feedback outputs, in capture order
+        std::filesystem::file_time_type vertexTime;
+        std::filesystem::file_time_type fragmentTime;
+        std::unordered_map<std::string, GLint> uniforms;
+        std::unordered_map<std::string, GLint> attributes;
+    };
+
+    Handle add(Program& program);
+    bool build(Program& program);
+    void introspect(Program& program);
+    static std::filesystem::file_time_type modifiedTime(const std::filesystem::path& path);
+
+    std::vector<Program> programs;
+    std::vector<std::pair<std::string, GLuint>> uniformBlocks;
+    double checkInterval;
+    std::chrono::steady_clock::time_point lastCheck;
+};
+
+#endif // SHADER_REGISTRY_H
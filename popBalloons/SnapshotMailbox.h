@@ -0,0 +1,47 @@
+#ifndef SNAPSHOT_MAILBOX_H
+#define SNAPSHOT_MAILBOX_H
+
+#include <atomic>
+
+// Triple-buffered handoff of the newest value from one producer thread to one
+// consumer thread. The producer fills its own slot and publishes it by swapping
+// it with the shared slot; the consumer swaps the shared slot for its own when a
+// newer value is there. Neither side ever waits, and a value is never written
+// while the consumer can see it. Values the consumer was too slow to pick up
+// are overwritten, so it always gets the latest.
+//
+// Slots keep their storage between uses, so a T made of vectors stops
+// allocating once every slot has grown to the working size.
+template <typename T>
+class SnapshotMailbox {
+public:
+    SnapshotMailbox() : shared(1), back(0), front(2) {}
+
+    // Producer only: the slot to fill before publish()
+    T& writeSlot() { return slots[back]; }
+
+    // Producer only: hands the filled slot over and takes a free one
+    void publish() {
+        back = shared.exchange(back | kFresh, std::memory_order_acq_rel) & kIndexMask;
+    }
+
+    // Consumer only: the newest published value, or the previous one if nothing new arrived.
+    // Stays valid and unchanged until the next call.
+    const T& latest() {
+        if (shared.load(std::memory_order_relaxed) & kFresh) {
+            front = shared.exchange(front, std::memory_order_acq_rel) & kIndexMask;
+        }
+        return slots[front];
+    }
+
+private:
+    static const unsigned kIndexMask = 3;
+    static const unsigned kFresh = 4; // Set on the shared index when the producer published since the last latest()
+
+    T slots[3];
+    std::atomic<unsigned> shared; // Slot in the middle, plus kFresh
+    unsigned back;                // Producer's slot
+    unsigned front;               // Consumer's slot
+};
+
+#endif // SNAPSHOT_MAILBOX_H
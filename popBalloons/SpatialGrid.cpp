@@ -0,0 +1,65 @@
+#include "SpatialGrid.h"
+#include <cmath>
+
+SpatialGrid::SpatialGrid(float minX, float minY, float maxX, float maxY, float cellSize)
+    : minX(minX),
+      minY(minY),
+      inverseCellSize(1.0f / cellSize),
+      columns(std::max(1, static_cast<int>(std::ceil((maxX - minX) / cellSize)))),
+      rows(std::max(1, static_cast<int>(std::ceil((maxY - minY) / cellSize)))),
+      cells(columns * rows)
+{
+}
+
+void SpatialGrid::clear() {
+    for (std::vector<uint32_t>& cell : cells) {
+        cell.clear();
+    }
+    itemCell.clear();
+    itemSlot.clear();
+}
+
+void SpatialGrid::insert(uint32_t item, float x, float y) {
+    uint32_t cell = cellOf(x, y);
+    itemCell.push_back(cell);
+    itemSlot.push_back(static_cast<uint32_t>(cells[cell].size()));
+    cells[cell].push_back(item);
+}
+
+void SpatialGrid::move(uint32_t item, float x, float y) {
+    uint32_t cell = cellOf(x, y);
+    if (cell == itemCell[item]) {
+        return;
+    }
+
+    unlink(item);
+    itemCell[item] = cell;
+    itemSlot[item] = static_cast<uint32_t>(cells[cell].size());
+    cells[cell].push_back(item);
+}
+
+void SpatialGrid::removeSwap(uint32_t item) {
+    unlink(item);
+
+    // Rename the last item to the freed id, exactly like the owning container does
+    uint32_t last = static_cast<uint32_t>(itemCell.size() - 1);
+    if (item != last) {
+        itemCell[item] = itemCell[last];
+        itemSlot[item] = itemSlot[last];
+        cells[itemCell[item]][itemSlot[item]] = item;
+    }
+
+    itemCell.pop_back();
+    itemSlot.pop_back();
+}
+
+// Takes the item out of its cell's list, leaving its itemCell/itemSlot entries stale
+void SpatialGrid::unlink(uint32_t item) {
+    std::vector<uint32_t>& cell = cells[itemCell[item]];
+    uint32_t slot = itemSlot[item];
+    uint32_t moved = cell.back();
+
+    cell[slot] = moved;
+    itemSlot[moved] = slot;
+    cell.pop_back();
+}
@@ -0,0 +1,52 @@
+#ifndef SPATIAL_GRID_H
+#define SPATIAL_GRID_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+
+// Uniform grid broadphase over a fixed rectangle of the play area.
+// Items are bucketed by their centre; anything outside the rectangle is clamped
+// into the border cells, so queries stay correct for stragglers.
+// Item ids are dense indices that mirror a swap-and-pop container: removeSwap
+// drops an id and renames the last id to take its place.
+class SpatialGrid {
+public:
+    SpatialGrid(float minX, float minY, float maxX, float maxY, float cellSize);
+
+    void clear();
+    void insert(uint32_t item, float x, float y); // item must equal size()
+    void move(uint32_t item, float x, float y);   // Cheap when the item stays in its cell
+    void removeSwap(uint32_t item);
+
+    size_t size() const { return itemCell.size(); }
+
+    // Calls fn(item) for every item whose cell overlaps the square around (x, y)
+    template <typename Fn>
+    void forEachNear(float x, float y, float radius, Fn fn) const {
+        int firstColumn = column(x - radius), lastColumn = column(x + radius);
+        int firstRow = row(y - radius), lastRow = row(y + radius);
+        for (int r = firstRow; r <= lastRow; ++r) {
+            for (int c = firstColumn; c <= lastColumn; ++c) {
+                for (uint32_t item : cells[r * columns + c]) {
+                    fn(item);
+                }
+            }
+        }
+    }
+
+private:
+    int column(float x) const { return std::min(std::max(static_cast<int>((x - minX) * inverseCellSize), 0), columns - 1); }
+    int row(float y) const { return std::min(std::max(static_cast<int>((y - minY) * inverseCellSize), 0), rows - 1); }
+    uint32_t cellOf(float x, float y) const { return static_cast<uint32_t>(row(y) * columns + column(x)); }
+    void unlink(uint32_t item);
+
+    float minX, minY;
+    float inverseCellSize;
+    int columns, rows;
+    std::vector<std::vector<uint32_t>> cells;
+    std::vector<uint32_t> itemCell; // Cell each item is bucketed in
+    std::vector<uint32_t> itemSlot; // Position of the item inside its cell's list
+};
+
+#endif // SPATIAL_GRID_H
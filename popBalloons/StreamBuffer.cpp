@@ -0,0 +1,138 @@
+#include "StreamBuffer.h"
+#include "Log.h"
+
+StreamBuffer::StreamBuffer()
+    : buffer(0),
+      regionSize(0),
+      region(0),
+      persistent(false),
+      mapped(false),
+      persistentMemory(nullptr)
+{
+    for (int i = 0; i < kRegionCount; ++i) {
+        fences[i] = 0;
+    }
+}
+
+StreamBuffer::~StreamBuffer() {
+    cleanup();
+}
+
+void StreamBuffer::initialize(size_t initialRegionSize) {
+    // Persistent mapping needs immutable storage; the 3.3 core profile only has it as an extension
+    persistent = GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+    allocate(initialRegionSize);
+}
+
+void StreamBuffer::cleanup() {
+    release();
+    regionSize = 0;
+    region = 0;
+}
+
+void* StreamBuffer::map(size_t bytes) {
+    if (bytes > regionSize) {
+        // Double until it fits; the old storage may still be read by queued draws, so drain it first
+        size_t newRegionSize = regionSize > 0 ? regionSize : 1;
+        while (newRegionSize < bytes) {
+            newRegionSize *= 2;
+        }
+        for (int i = 0; i < kRegionCount; ++i) {
+            waitForRegion(i);
+        }
+        release();
+        allocate(newRegionSize);
+    }
+
+    waitForRegion(region);
+
+    GLintptr offset = static_cast<GLintptr>(region) * static_cast<GLintptr>(regionSize);
+    if (persistent) {
+        return persistentMemory + offset;
+    }
+
+    // The fence already guarantees the GPU is done with this region, so skip the driver's own sync
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+    void* memory = glMapBufferRange(GL_ARRAY_BUFFER, offset, bytes,
+                                    GL_MAP_WRITE_BIT | GL_MAP_UNSYNCHRONIZED_BIT | GL_MAP_INVALIDATE_RANGE_BIT);
+    mapped = memory != nullptr;
+    return memory;
+}
+
+GLintptr StreamBuffer::unmap() {
+    if (mapped) {
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+        mapped = false;
+    }
+    return static_cast<GLintptr>(region) * static_cast<GLintptr>(regionSize);
+}
+
+void StreamBuffer::fence() {
+    fences[region] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    region = (region + 1) % kRegionCount;
+}
+
+void StreamBuffer::allocate(size_t newRegionSize) {
+    regionSize = newRegionSize;
+    region = 0;
+
+    GLsizeiptr totalSize = static_cast<GLsizeiptr>(regionSize * kRegionCount);
+    glGenBuffers(1, &buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+    if (persistent) {
+        const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_ARRAY_BUFFER, totalSize, nullptr, flags);
+        persistentMemory = static_cast<unsigned char*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, totalSize, flags));
+        if (persistentMemory) {
+            return;
+        }
+
+        // Immutable storage cannot be respecified, so start over with a plain buffer
+        LOG_ERROR("Persistent mapping of a %zu byte stream buffer failed; mapping each region instead",
+                  regionSize * kRegionCount);
+        glDeleteBuffers(1, &buffer);
+        glGenBuffers(1, &buffer);
+        glBindBuffer(GL_ARRAY_BUFFER, buffer);
+        persistent = false;
+    }
+
+    glBufferData(GL_ARRAY_BUFFER, totalSize, nullptr, GL_STREAM_DRAW);
+}
+
+void StreamBuffer::release() {
+    for (int i = 0; i < kRegionCount; ++i) {
+        if (fences[i]) {
+            glDeleteSync(fences[i]);
+            fences[i] = 0;
+        }
+    }
+
+    if (buffer) {
+        if (persistentMemory || mapped) {
+            glBindBuffer(GL_ARRAY_BUFFER, buffer);
+            glUnmapBuffer(GL_ARRAY_BUFFER);
+            persistentMemory = nullptr;
+            mapped = false;
+        }
+        glDeleteBuffers(1, &buffer);
+        buffer = 0;
+    }
+}
+
+void StreamBuffer::waitForRegion(int index) {
+    GLsync sync = fences[index];
+    if (!sync) {
+        return;
+    }
+
+    // Flush once so the fence is guaranteed to signal, then block until it does
+    GLenum result = glClientWaitSync(sync, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+    while (result == GL_TIMEOUT_EXPIRED) {
+        result = glClientWaitSync(sync, 0, 1000000); // 1 ms
+    }
+
+    glDeleteSync(sync);
+    fences[index] = 0;
+}
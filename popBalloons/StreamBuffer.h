@@ -0,0 +1,49 @@
+#ifndef STREAM_BUFFER_H
+#define STREAM_BUFFER_H
+
+#include <GL/glew.h>
+#include <cstddef>
+
+// GPU buffer for data that is rewritten every frame.
+// The buffer is split into kRegionCount regions used round-robin; each region
+// is guarded by a fence so the CPU never writes memory the GPU may still read.
+// With GL 4.4 / ARB_buffer_storage the whole buffer stays persistently mapped;
+// on the plain 3.3 core profile, or if the persistent map fails, each region is
+// mapped unsynchronized instead.
+//
+// Per frame: map() -> write -> unmap() -> draw from the returned offset -> fence().
+class StreamBuffer {
+public:
+    static const int kRegionCount = 3;
+
+    StreamBuffer();
+    ~StreamBuffer();
+
+    void initialize(size_t initialRegionSize);
+    void cleanup();
+
+    // Returns write-only memory for `bytes` of data in the current region; grows the buffer if needed
+    void* map(size_t bytes);
+    // Finishes the writes and returns the byte offset of the region inside getBuffer()
+    GLintptr unmap();
+    // Marks the current region as in flight and moves on to the next one
+    void fence();
+
+    GLuint getBuffer() const { return buffer; }
+    bool isPersistent() const { return persistent; }
+
+private:
+    void allocate(size_t newRegionSize);
+    void release();
+    void waitForRegion(int index);
+
+    GLuint buffer;
+    size_t regionSize;
+    int region;
+    bool persistent;
+    bool mapped;
+    unsigned char* persistentMemory;
+    GLsync fences[kRegionCount];
+};
+
+#endif // STREAM_BUFFER_H
@@ -1,10 +0,0 @@
-#ifndef VERTEX_H
-#define VERTEX_H
-
-
-struct Vertex {
-    float x, y; // Position
-    float r, g, b, a; // Color
-};
-
-#endif // VERTEX_H
\ No newline at end of file
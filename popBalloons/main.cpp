@@ -1,20 +1,147 @@
 #include <iostream>
+#include <cstring>
+#include <cstdlib>
+#include <random>
+#include "Game.h"
+#include "Headless.h"
+#include "Replay.h"
+#include "Log.h"
+
+// --seed N pins the random generator; otherwise each run draws a fresh seed
+static uint32_t parseSeed(int argc, char* argv[]) {
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (strcmp(argv[i], "--seed") == 0) {
+            return static_cast<uint32_t>(strtoul(argv[i + 1], nullptr, 10));
+        }
+    }
+    return std::random_device{}();
+}
+
+// Steps the simulation without a window, e.g.
+//   popBalloons --headless --ticks 1000000 --autopop 30 --restart --seed 42
+static int runHeadless(int argc, char* argv[]) {
+    HeadlessConfig config;
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--ticks") == 0 && hasValue) {
+            config.maxTicks = strtoull(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--dt") == 0 && hasValue) {
+            config.fixedDeltaTime = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--tps") == 0 && hasValue) {
+            config.ticksPerSecond = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--autopop") == 0 && hasValue) {
+            config.autoPopInterval = static_cast<unsigned int>(strtoul(argv[++i], nullptr, 10));
+        } else if (strcmp(argv[i], "--restart") == 0) {
+            config.restartOnGameOver = true;
+        }
+    }
+
+    Game game(parseSeed(argc, argv));
+    SteadyClock clock;
+    HeadlessRunner runner(game, clock);
+    HeadlessStats stats = runner.run(config);
 
+    // Let queued game-over messages land before the summary
+    Log::flush();
 
-int main_cpp = []() -> int {
-    std::cout << "main.cpp top-level static initialization." << std::endl;
+    std::cout << "Headless run: " << stats.ticks << " ticks, "
+              << stats.gamesPlayed << " games, "
+              << stats.balloonsPopped << " balloons popped, last score " << stats.lastScore << ", "
+              << stats.wallSeconds << " s";
+    if (stats.wallSeconds > 0.0) {
+        std::cout << " (" << static_cast<double>(stats.ticks) / stats.wallSeconds << " ticks/s)";
+    }
+    std::cout << ", seed " << game.getSeed() << ", state " << std::hex << game.stateHash() << std::dec << std::endl;
     return 0;
-}();
-#include "Game.h"
+}
+
+// Re-runs a session recorded with --record as fast as possible, e.g.
+//   popBalloons --replay session.pbrp
+// The state hash matches across runs and machines with the same build, so a
+// change in it flags a behavioural change rather than a performance one.
+// Exits with 1 when the final tick count or state hash differs from the one the
+// recording ended with.
+static int runReplay(const char* path) {
+    ReplayPlayer player;
+    if (!player.open(path)) {
+        Log::flush();
+        return 1;
+    }
+
+    Game game(player.getSeed());
+    game.setFramebufferSize(player.getFramebufferWidth(), player.getFramebufferHeight());
+
+    SteadyClock clock;
+    double start = clock.now();
+    while (player.step(game)) {
+    }
+    double wallSeconds = clock.now() - start;
+
+    Log::flush();
+
+    std::cout << "Replay " << path << ": " << player.getTicks() << " ticks, score " << game.getScore()
+              << ", lives " << game.getLives() << ", " << wallSeconds << " s";
+    if (wallSeconds > 0.0) {
+        std::cout << " (" << static_cast<double>(player.getTicks()) / wallSeconds << " ticks/s)";
+    }
+    std::cout << ", state " << std::hex << game.stateHash() << std::dec << std::endl;
+
+    if (!player.hasEnd()) {
+        std::cout << "The recording has no end marker; nothing to compare against" << std::endl;
+        return 0;
+    }
+    if (player.getTicks() != player.getRecordedTicks() || game.stateHash() != player.getRecordedStateHash()) {
+        std::cout << "Mismatch: the recording ended after " << player.getRecordedTicks() << " ticks with state "
+                  << std::hex << player.getRecordedStateHash() << std::dec << std::endl;
+        return 1;
+    }
+    std::cout << "Matches the recorded session" << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            return runHeadless(argc, argv);
+        }
+        if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            return runReplay(argv[i + 1]);
+        }
+    }
 
-int main() {
-    std::cout << "Starting popBalloons game..." << std::endl;
+    LOG_INFO("Starting popBalloons game...");
 
     
-    Game game;
-    std::cout << "Game instance created, entering the game loop." << std::endl;
+    Game game(parseSeed(argc, argv));
+    for (int i = 1; i < argc; ++i) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--gpu-particles") == 0) {
+            game.setParticleBackend(ParticleBackend::TransformFeedback);
+        } else if (strcmp(argv[i], "--analytic-particles") == 0) {
+            game.setParticleBackend(ParticleBackend::Analytic);
+        } else if (strcmp(argv[i], "--sdf-balloons") == 0) {
+            game.setBalloonShading(BalloonShading::Sdf);
+        } else if (!hasValue) {
+            continue;
+        } else if (strcmp(argv[i], "--trace") == 0) {
+            game.setTraceOutput(argv[i + 1]);
+        } else if (strcmp(argv[i], "--record") == 0) {
+            game.setRecordOutput(argv[i + 1]);
+        } else if (strcmp(argv[i], "--tick-rate") == 0) {
+            double ticksPerSecond = atof(argv[i + 1]);
+            if (ticksPerSecond > 0.0) {
+                game.setTickRate(ticksPerSecond);
+            }
+        } else if (strcmp(argv[i], "--max-catchup") == 0) {
+            int steps = atoi(argv[i + 1]);
+            if (steps > 0) {
+                game.setMaxCatchUpSteps(steps);
+            }
+        }
+    }
+    LOG_INFO("Game instance created, entering the game loop.");
     game.run();
-    std::cout << "Exiting the game loop, game ended." << std::endl;
+    LOG_INFO("Exiting the game loop, game ended.");
 
     return 0;
 }
\ No newline at end of file
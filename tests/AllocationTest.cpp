@@ -0,0 +1,180 @@
+// Heap traffic of a steady-state simulation step, counted by replacing the global
+// operator new and delete. The replacement slows every allocation down, so it
+// lives in the test binary rather than next to the benchmarks. Once the pools and
+// snapshot arenas have warmed up, a step plus its snapshot handoff must not
+// allocate at all. Only the simulation side is checked: the render-side frame
+// needs a GL context.
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+#include <popBalloons/Game.h>
+#include <popBalloons/RenderSnapshot.h>
+#include <popBalloons/SnapshotMailbox.h>
+#include "Checks.h"
+
+namespace {
+
+std::atomic<size_t> allocationCount(0);
+
+// Every replaced operator new and delete below goes through this one pair,
+// so each pointer is always released by the function family that made it
+void* allocate(size_t bytes, size_t alignment) noexcept {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (alignment < alignof(std::max_align_t)) {
+        alignment = alignof(std::max_align_t);
+    }
+#ifdef _MSC_VER
+    return _aligned_malloc(bytes ? bytes : 1, alignment);
+#else
+    void* memory = nullptr;
+    return posix_memalign(&memory, alignment, bytes ? bytes : 1) == 0 ? memory : nullptr;
+#endif
+}
+
+void release(void* memory) noexcept {
+#ifdef _MSC_VER
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+void* allocateOrThrow(size_t bytes, size_t alignment) {
+    if (void* memory = allocate(bytes, alignment)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+} // namespace
+
+void* operator new(size_t bytes) {
+    return allocateOrThrow(bytes, 0);
+}
+
+void* operator new[](size_t bytes) {
+    return allocateOrThrow(bytes, 0);
+}
+
+void* operator new(size_t bytes, const std::nothrow_t&) noexcept {
+    return allocate(bytes, 0);
+}
+
+void* operator new[](size_t bytes, const std::nothrow_t&) noexcept {
+    return allocate(bytes, 0);
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment) {
+    return allocateOrThrow(bytes, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment) {
+    return allocateOrThrow(bytes, static_cast<size_t>(alignment));
+}
+
+void* operator new(size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(bytes, static_cast<size_t>(alignment));
+}
+
+void* operator new[](size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept {
+    return allocate(bytes, static_cast<size_t>(alignment));
+}
+
+void operator delete(void* memory) noexcept {
+    release(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    release(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+    release(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept {
+    release(memory);
+}
+
+void operator delete(void* memory, const std::nothrow_t&) noexcept {
+    release(memory);
+}
+
+void operator delete[](void* memory, const std::nothrow_t&) noexcept {
+    release(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+    release(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept {
+    release(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept {
+    release(memory);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept {
+    release(memory);
+}
+
+void operator delete(void* memory, std::align_val_t, const std::nothrow_t&) noexcept {
+    release(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t, const std::nothrow_t&) noexcept {
+    release(memory);
+}
+
+namespace {
+
+const float kDeltaTime = 1.0f / 120.0f;
+const int kAutoPopInterval = 30;
+const int kWarmUpSteps = 20000;
+const int kMeasuredSteps = 20000;
+
+// One tick the way the simulation thread runs it, with a click standing in for the player
+void step(Game& game, SnapshotMailbox<RenderSnapshot>& snapshots, uint64_t tick) {
+    if (tick % kAutoPopInterval == 0) {
+        game.popHighestBalloon();
+    }
+    game.update(kDeltaTime);
+    if (game.isGameOver()) {
+        game.reset();
+    }
+
+    snapshots.writeSlot().capture(game.getBalloons(), game.getFragments());
+    snapshots.publish();
+}
+
+} // namespace
+
+CheckResult checkSteadyStateAllocations() {
+    Game game(42);
+    SnapshotMailbox<RenderSnapshot> snapshots;
+    uint64_t tick = 0;
+    for (; tick < kWarmUpSteps; ++tick) {
+        step(game, snapshots, tick);
+    }
+
+    size_t before = allocationCount.load(std::memory_order_relaxed);
+    for (int i = 0; i < kMeasuredSteps; ++i) {
+        step(game, snapshots, tick++);
+    }
+    size_t allocations = allocationCount.load(std::memory_order_relaxed) - before;
+
+    std::printf("%zu allocations over %d steps, arena peak %zu bytes, %zu arena overflows\n",
+                allocations, kMeasuredSteps, snapshots.writeSlot().arena.getPeakBytes(),
+                snapshots.writeSlot().arena.getOverflowCount());
+    return allocations == 0 ? CheckResult::Passed : CheckResult::Failed;
+}
@@ -0,0 +1,17 @@
+#ifndef POPBALLOONS_CHECKS_H
+#define POPBALLOONS_CHECKS_H
+
+// Correctness checks run by popBalloons_tests; see tests/main.cpp.
+// Each prints what it measured.
+
+enum class CheckResult {
+    Passed,
+    Failed,
+    Skipped // The check could not run here, e.g. without a GL context
+};
+
+CheckResult checkSteadyStateAllocations();
+CheckResult checkTopmostIsVisible();
+CheckResult checkGpuParticlesMatchCpu();
+
+#endif // POPBALLOONS_CHECKS_H
@@ -0,0 +1,123 @@
+// The transform feedback backend must move fragments the way ParticleSystem
+// does. Runs the same burst through both for a fixed number of steps, reads
+// the GPU ring back and compares every fragment. Needs a GL 3.3 context; a
+// software driver such as Mesa's llvmpipe is enough (LIBGL_ALWAYS_SOFTWARE=1).
+
+#include <GL/glew.h>
+#include <glfw3.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+#include <glm/glm.hpp>
+
+#include <popBalloons/Fragment.h>
+#include <popBalloons/GpuParticleSystem.h>
+#include <popBalloons/ParticleSystem.h>
+#include <popBalloons/ShaderRegistry.h>
+#include "Checks.h"
+
+namespace {
+
+const size_t kParticleCount = 200000;
+const int kSteps = 60;
+const float kDeltaTime = 1.0f / 120.0f;
+// The GPU may contract multiply-adds that the SIMD kernel rounds separately
+const float kTolerance = 1.0e-4f;
+
+// A hidden window for its context; nullptr when no GL 3.3 driver is available
+GLFWwindow* createContext() {
+    if (!glfwInit()) {
+        return nullptr;
+    }
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+    GLFWwindow* window = glfwCreateWindow(64, 64, "popBalloons_tests", nullptr, nullptr);
+    if (!window) {
+        glfwTerminate();
+        return nullptr;
+    }
+    glfwMakeContextCurrent(window);
+
+    glewExperimental = GL_TRUE;
+    if (glewInit() != GLEW_OK) {
+        glfwDestroyWindow(window);
+        glfwTerminate();
+        return nullptr;
+    }
+    glGetError(); // glewInit can leave GL_INVALID_ENUM behind on core profiles
+    return window;
+}
+
+float difference(const glm::vec4& a, const glm::vec4& b) {
+    glm::vec4 d = glm::abs(a - b);
+    return std::max(std::max(d.x, d.y), std::max(d.z, d.w));
+}
+
+} // namespace
+
+CheckResult checkGpuParticlesMatchCpu() {
+    GLFWwindow* window = createContext();
+    if (!window) {
+        std::printf("No GL 3.3 context available\n");
+        return CheckResult::Skipped;
+    }
+
+    CheckResult result = CheckResult::Failed;
+    {
+        ShaderRegistry shaders;
+        GpuParticleSystem gpu;
+        if (!gpu.initialize(shaders)) {
+            std::printf("Transform feedback particles failed to initialize\n");
+        } else {
+            std::mt19937 gen(42);
+            std::uniform_real_distribution<float> dis(-1.0f, 1.0f);
+            std::uniform_real_distribution<float> disColor(0.0f, 1.0f);
+
+            ParticleSystem cpu;
+            cpu.reserve(kParticleCount);
+            for (size_t i = 0; i < kParticleCount; ++i) {
+                GpuParticle particle = { glm::vec3(dis(gen), dis(gen), 0.0f), glm::vec3(dis(gen), dis(gen), dis(gen)),
+                                         glm::vec4(disColor(gen), disColor(gen), disColor(gen), 1.0f), 5.0f, 1.0f };
+                cpu.emit(Fragment(particle.position, particle.velocity, particle.color, particle.size, particle.lifetime));
+                gpu.emit(particle, 0.0);
+            }
+
+            // A zero step only uploads the burst, which was spawned at time 0
+            gpu.update(0.0f, 0.0);
+            for (int step = 1; step <= kSteps; ++step) {
+                cpu.update(kDeltaTime);
+                gpu.update(kDeltaTime, step * static_cast<double>(kDeltaTime));
+            }
+
+            std::vector<GpuParticle> readBack(static_cast<size_t>(gpu.getActiveSlots()));
+            glBindBuffer(GL_ARRAY_BUFFER, gpu.getStateBuffer());
+            glGetBufferSubData(GL_ARRAY_BUFFER, 0, readBack.size() * sizeof(GpuParticle), readBack.data());
+
+            if (readBack.size() != cpu.size()) {
+                std::printf("%zu fragments on the GPU, %zu on the CPU\n", readBack.size(), cpu.size());
+            } else {
+                float worst = 0.0f;
+                for (size_t i = 0; i < readBack.size(); ++i) {
+                    const GpuParticle& g = readBack[i];
+                    worst = std::max(worst, difference(glm::vec4(g.position, g.lifetime), glm::vec4(cpu.getPosition(i), cpu.getLifetime(i))));
+                    worst = std::max(worst, difference(g.color, cpu.getColor(i)));
+                }
+                std::printf("%zu fragments over %d steps, largest difference %g\n", readBack.size(), kSteps, worst);
+                if (glGetError() != GL_NO_ERROR) {
+                    std::printf("GL reported an error\n");
+                } else if (worst <= kTolerance) {
+                    result = CheckResult::Passed;
+                }
+            }
+        }
+        gpu.cleanup();
+    }
+
+    glfwDestroyWindow(window);
+    glfwTerminate();
+    return result;
+}
@@ -0,0 +1,82 @@
+// Clicks must pop the balloon the player sees. Balloons are drawn grouped by
+// level of detail, not in spawn order, and swap-and-pop moves them around the
+// pool, so this replays the depth test on a captured snapshot the way the
+// renderer draws it and compares the survivor with what HitPick::Topmost picks.
+
+#include <cstdio>
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <popBalloons/Balloon.h>
+#include <popBalloons/BalloonPool.h>
+#include <popBalloons/CircleLod.h>
+#include <popBalloons/ParticleSystem.h>
+#include <popBalloons/RenderSnapshot.h>
+#include <popBalloons/Renderer.h>
+#include "Checks.h"
+
+namespace {
+
+// Which of the snapshot's balloons covering a point survives GL_LESS when drawn in this order
+size_t visibleBalloon(const RenderSnapshot& snapshot, const std::vector<size_t>& drawOrder,
+                      const glm::mat4& projection, float worldX, float worldY) {
+    const size_t count = snapshot.balloonPosition.size();
+    size_t visible = drawOrder.front();
+    float nearest = 2.0f;
+    for (size_t i : drawOrder) {
+        glm::vec2 offset = glm::vec2(worldX, worldY) - snapshot.balloonPosition[i];
+        if (glm::dot(offset, offset) > snapshot.balloonSize[i] * snapshot.balloonSize[i]) {
+            continue;
+        }
+        glm::vec4 clip = projection * glm::vec4(snapshot.balloonPosition[i], Renderer::balloonDepth(i, count), 1.0f);
+        float depth = 0.5f * clip.z / clip.w + 0.5f;
+        if (depth < nearest) {
+            nearest = depth;
+            visible = i;
+        }
+    }
+    return visible;
+}
+
+} // namespace
+
+CheckResult checkTopmostIsVisible() {
+    const float viewportHeight = 720.0f;
+    const glm::mat4 projection = glm::ortho(-1.0f, 1.0f, -1.0f, 1.0f);
+    const float pixelsPerUnit = projection[1][1] * 0.5f * viewportHeight;
+
+    // A small balloon added after a large one it overlaps falls in a coarser
+    // level of detail, so the grouped draws put it first. Removing the balloon
+    // spawned before both swaps the small one to the front of the pool.
+    BalloonPool balloons;
+    balloons.add(Balloon(glm::vec3(-0.8f, -0.8f, 0.0f), 0.05f, glm::vec3(0.0f, 1.0f, 0.0f))); // Popped below
+    balloons.add(Balloon(glm::vec3(0.0f, 0.0f, 0.0f), 0.3f, glm::vec3(1.0f, 0.0f, 0.0f)));    // Large
+    balloons.add(Balloon(glm::vec3(0.1f, 0.0f, 0.0f), 0.05f, glm::vec3(0.0f, 0.0f, 1.0f)));   // Small
+    balloons.remove(0);
+    if (balloons.getSize()[0] != 0.05f) {
+        std::printf("Removing the first balloon no longer moves the small one to index 0\n");
+        return CheckResult::Failed;
+    }
+
+    ParticleSystem noFragments;
+    RenderSnapshot snapshot;
+    snapshot.capture(balloons, noFragments);
+    if (CircleLod::levelFor(snapshot.balloonSize[1] * pixelsPerUnit) >= CircleLod::levelFor(snapshot.balloonSize[0] * pixelsPerUnit)) {
+        std::printf("The small balloon no longer draws before the large one\n");
+        return CheckResult::Failed;
+    }
+
+    const float clickX = 0.1f;
+    const float clickY = 0.0f;
+    size_t drawnByLevel = visibleBalloon(snapshot, { 1, 0 }, projection, clickX, clickY);
+    size_t drawnInSpawnOrder = visibleBalloon(snapshot, { 0, 1 }, projection, clickX, clickY);
+
+    size_t hit = 0;
+    bool found = balloons.findHit(clickX, clickY, 1.0f, HitPick::Topmost, hit);
+    bool hitIsVisible = found && snapshot.balloonSize[drawnByLevel] == balloons.getSize()[hit];
+    std::printf("Visible: size %.2f drawn by level, %.2f drawn in spawn order; click popped %s%.2f\n",
+                snapshot.balloonSize[drawnByLevel], snapshot.balloonSize[drawnInSpawnOrder],
+                found ? "size " : "nothing, ", found ? balloons.getSize()[hit] : 0.0f);
+    return hitIsVisible && drawnByLevel == drawnInSpawnOrder ? CheckResult::Passed : CheckResult::Failed;
+}
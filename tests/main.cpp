@@ -0,0 +1,59 @@
+// popBalloons_tests: runs one named check, or every check when given no name.
+// The exit code is 1 if any check fails, and kSkippedExitCode if every check
+// that ran was skipped, so ctest can register each check as its own test.
+
+#include <cstdio>
+#include <cstring>
+
+#include "Checks.h"
+
+namespace {
+
+const int kSkippedExitCode = 77; // ctest's SKIP_RETURN_CODE for these tests
+
+struct Check {
+    const char* name;
+    CheckResult (*run)();
+};
+
+const Check kChecks[] = {
+    { "steady_state_allocations", checkSteadyStateAllocations },
+    { "topmost_is_visible", checkTopmostIsVisible },
+    { "gpu_particles_match_cpu", checkGpuParticlesMatchCpu },
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const char* only = argc > 1 ? argv[1] : nullptr;
+
+    int ran = 0;
+    int failed = 0;
+    int skipped = 0;
+    for (const Check& check : kChecks) {
+        if (only && std::strcmp(only, check.name) != 0) {
+            continue;
+        }
+        ++ran;
+        std::printf("[ RUN  ] %s\n", check.name);
+        CheckResult result = check.run();
+        if (result == CheckResult::Passed) {
+            std::printf("[  OK  ] %s\n", check.name);
+        } else if (result == CheckResult::Skipped) {
+            std::printf("[ SKIP ] %s\n", check.name);
+            ++skipped;
+        } else {
+            std::printf("[ FAIL ] %s\n", check.name);
+            ++failed;
+        }
+    }
+
+    if (ran == 0) {
+        std::fprintf(stderr, "No check named %s\n", only);
+        return 2;
+    }
+    if (failed > 0) {
+        return 1;
+    }
+    return skipped == ran ? kSkippedExitCode : 0;
+}
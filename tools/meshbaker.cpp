@@ -0,0 +1,31 @@
+// Offline baker for .pbmesh files, e.g.
+//   meshbaker --tangents suzanne.obj suzanne.pbmesh
+// loadMeshCached() bakes on demand too; this lets a build step do it ahead of time.
+
+#include <cstdio>
+#include <cstring>
+
+#include <GL/glew.h>
+
+#include <common/meshcache.hpp>
+
+int main(int argc, char* argv[]) {
+    bool withTangents = false;
+    const char* paths[2] = { nullptr, nullptr };
+    int pathCount = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--tangents") == 0) {
+            withTangents = true;
+        } else if (pathCount < 2) {
+            paths[pathCount++] = argv[i];
+        }
+    }
+
+    if (pathCount != 2) {
+        fprintf(stderr, "Usage: %s [--tangents] input.obj output.pbmesh\n", argv[0]);
+        return 2;
+    }
+
+    return bakeMesh(paths[0], paths[1], withTangents) ? 0 : 1;
+}